@@ -1,8 +1,141 @@
 #include "eudaq/OptionParser.hh"
 #include "eudaq/DataConverter.hh"
+#include "eudaq/StdEventConverter.hh"
 #include "eudaq/FileWriter.hh"
 #include "eudaq/FileReader.hh"
 #include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <chrono>
+#include <exception>
+
+namespace{
+  struct Item{
+    uint64_t seq;
+    eudaq::EventSPC ev;
+    std::shared_ptr<void> cvt;
+  };
+
+  // Hands events from the reader over to the workers and then, in the
+  // original order, from the workers to the writer.
+  class Pipeline{
+  public:
+    Pipeline(size_t depth):m_depth(depth), m_read(0), m_next(0), m_eof(false){};
+
+    bool PushInput(eudaq::EventSPC ev){
+      std::unique_lock<std::mutex> lk(m_mtx);
+      m_cv_in_space.wait(lk, [this]{return m_in.size() < m_depth || m_error;});
+      if(m_error)
+	return false;
+      m_in.push_back(Item{m_read++, ev, nullptr});
+      m_cv_in.notify_one();
+      return true;
+    };
+
+    bool PopInput(Item &item){
+      std::unique_lock<std::mutex> lk(m_mtx);
+      m_cv_in.wait(lk, [this]{return !m_in.empty() || m_eof || m_error;});
+      if(m_in.empty() || m_error)
+	return false;
+      item = std::move(m_in.front());
+      m_in.pop_front();
+      m_cv_in_space.notify_one();
+      // bound the reorder buffer, a slow event must not let the others pile up
+      m_cv_out_space.wait(lk, [this, &item]{return item.seq < m_next + m_depth || m_error;});
+      return !m_error;
+    };
+
+    void PushOutput(Item &&item){
+      std::unique_lock<std::mutex> lk(m_mtx);
+      m_out[item.seq] = std::move(item);
+      m_cv_out.notify_all();
+    };
+
+    bool PopOutput(Item &item){
+      std::unique_lock<std::mutex> lk(m_mtx);
+      m_cv_out.wait(lk, [this]{
+	  return m_out.count(m_next) || (m_eof && m_next == m_read) || m_error;});
+      if(m_error || !m_out.count(m_next))
+	return false;
+      item = std::move(m_out[m_next]);
+      m_out.erase(m_next++);
+      m_cv_out_space.notify_all();
+      return true;
+    };
+
+    void SetEOF(){
+      std::unique_lock<std::mutex> lk(m_mtx);
+      m_eof = true;
+      m_cv_in.notify_all();
+      m_cv_out.notify_all();
+    };
+
+    void SetError(std::exception_ptr e){
+      std::unique_lock<std::mutex> lk(m_mtx);
+      if(!m_error)
+	m_error = e;
+      m_cv_in.notify_all();
+      m_cv_in_space.notify_all();
+      m_cv_out.notify_all();
+      m_cv_out_space.notify_all();
+    };
+
+    std::exception_ptr Error(){
+      std::unique_lock<std::mutex> lk(m_mtx);
+      return m_error;
+    };
+
+  private:
+    size_t m_depth;
+    uint64_t m_read;
+    uint64_t m_next;
+    bool m_eof;
+    std::exception_ptr m_error;
+    std::deque<Item> m_in;
+    std::map<uint64_t, Item> m_out;
+    std::mutex m_mtx;
+    std::condition_variable m_cv_in;
+    std::condition_variable m_cv_in_space;
+    std::condition_variable m_cv_out;
+    std::condition_variable m_cv_out_space;
+  };
+
+  class Progress{
+  public:
+    Progress(uint32_t interval)
+      :m_interval(interval), m_n(0), m_start(std::chrono::steady_clock::now()),
+       m_last(m_start){};
+    void Count(){
+      m_n++;
+      if(!m_interval)
+	return;
+      auto now = std::chrono::steady_clock::now();
+      if(now - m_last >= std::chrono::seconds(m_interval)){
+	Print(now);
+	m_last = now;
+      }
+    };
+    void Print(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now()){
+      double s = std::chrono::duration<double>(now - m_start).count();
+      std::cout<<"Converted "<<m_n<<" events in "<<s<<" s ("
+	       <<(s > 0 ? m_n / s : 0)<<" events/s)"<<std::endl;
+    };
+  private:
+    uint32_t m_interval;
+    uint64_t m_n;
+    std::chrono::steady_clock::time_point m_start;
+    std::chrono::steady_clock::time_point m_last;
+  };
+
+  eudaq::EventSPC ToStdEvent(eudaq::EventSPC ev){
+    auto evstd = eudaq::StandardEvent::MakeShared();
+    eudaq::StdEventConverter::Convert(ev, evstd, nullptr);
+    return evstd;
+  }
+}
 
 int main(int /*argc*/, const char **argv) {
   eudaq::OptionParser op("EUDAQ Command Line DataConverter", "2.0", "The Data Converter launcher of EUDAQ");
@@ -11,6 +144,13 @@ int main(int /*argc*/, const char **argv) {
   eudaq::Option<std::string> file_output(op, "o", "output", "", "string",
 					 "output file");
   eudaq::OptionFlag iprint(op, "ip", "iprint", "enable print of input Event");
+  eudaq::OptionFlag stdev(op, "std", "stdevent", "convert to StdEvent before writing");
+  eudaq::Option<uint32_t> threads(op, "j", "threads", 0, "uint32_t",
+				  "number of conversion threads (0: convert on the main thread)");
+  eudaq::Option<uint32_t> depth(op, "q", "queue", 256, "uint32_t",
+				"number of events in flight between the pipeline stages");
+  eudaq::Option<uint32_t> report(op, "r", "report", 10, "uint32_t",
+				 "seconds between progress reports (0: only at the end)");
 
   try{
     op.Parse(argv);
@@ -18,36 +158,108 @@ int main(int /*argc*/, const char **argv) {
   catch (...) {
     return op.HandleMainException();
   }
-  
+
   std::string infile_path = file_input.Value();
   if(infile_path.empty()){
     std::cout<<"option --help to get help"<<std::endl;
     return 1;
   }
-  
+
   std::string outfile_path = file_output.Value();
   std::string type_in = infile_path.substr(infile_path.find_last_of(".")+1);
   std::string type_out = outfile_path.substr(outfile_path.find_last_of(".")+1);
   bool print_ev_in = iprint.Value();
-  
+  bool stdev_v = stdev.Value();
+  uint32_t nthreads = threads.Value();
+
   if(type_in=="raw")
     type_in = "native";
   if(type_out=="raw")
     type_out = "native";
-  
+
   eudaq::FileReaderUP reader;
   eudaq::FileWriterUP writer;
   reader = eudaq::Factory<eudaq::FileReader>::MakeUnique(eudaq::str2hash(type_in), infile_path);
   if(!type_out.empty())
     writer = eudaq::Factory<eudaq::FileWriter>::MakeUnique(eudaq::str2hash(type_out), outfile_path);
-  while(1){
-    auto ev = reader->GetNextEvent();
-    if(!ev)
-      break;
-    if(print_ev_in)
-      ev->Print(std::cout);
-    if(writer)
-      writer->WriteEvent(ev);
+  Progress progress(report.Value());
+
+  if(!nthreads){
+    while(1){
+      auto ev = reader->GetNextEvent();
+      if(!ev)
+	break;
+      if(print_ev_in)
+	ev->Print(std::cout);
+      if(stdev_v)
+	ev = ToStdEvent(ev);
+      if(writer)
+	writer->WriteEvent(ev);
+      progress.Count();
+    }
+    progress.Print();
+    return 0;
+  }
+
+  // reader thread -> conversion threads -> writer (this thread) in input order
+  Pipeline pipe(depth.Value() ? depth.Value() : 1);
+  std::thread th_reader([&](){
+      try{
+	while(1){
+	  auto ev = reader->GetNextEvent();
+	  if(!ev)
+	    break;
+	  if(print_ev_in)
+	    ev->Print(std::cout);
+	  if(!pipe.PushInput(ev))
+	    break;
+	}
+      }
+      catch(...){
+	pipe.SetError(std::current_exception());
+      }
+      pipe.SetEOF();
+    });
+  std::vector<std::thread> th_workers;
+  for(uint32_t i = 0; i < nthreads; i++){
+    th_workers.emplace_back([&](){
+	try{
+	  Item item;
+	  while(pipe.PopInput(item)){
+	    if(stdev_v)
+	      item.ev = ToStdEvent(item.ev);
+	    if(writer)
+	      item.cvt = writer->ConvertEvent(item.ev);
+	    pipe.PushOutput(std::move(item));
+	  }
+	}
+	catch(...){
+	  pipe.SetError(std::current_exception());
+	}
+      });
+  }
+  try{
+    Item item;
+    while(pipe.PopOutput(item)){
+      if(writer)
+	writer->WriteConverted(item.ev, item.cvt);
+      progress.Count();
+    }
+  }
+  catch(...){
+    pipe.SetError(std::current_exception());
+  }
+  th_reader.join();
+  for(auto &th: th_workers)
+    th.join();
+  progress.Print();
+  if(pipe.Error()){
+    try{
+      std::rethrow_exception(pipe.Error());
+    }
+    catch(...){
+      return op.HandleMainException();
+    }
   }
   return 0;
 }
@@ -0,0 +1,37 @@
+#include "eudaq/OptionParser.hh"
+#include "eudaq/EventIndex.hh"
+#include <iostream>
+
+int main(int /*argc*/, const char **argv) {
+  eudaq::OptionParser op("EUDAQ Command Line Event Indexer", "2.0",
+			 "Build the sidecar event index of a native .raw file");
+  eudaq::Option<std::string> file_input(op, "i", "input", "", "string", "input file");
+  eudaq::Option<std::string> file_output(op, "o", "output", "", "string",
+					 "output index file (default: <input>.idx)");
+  eudaq::OptionFlag overwrite(op, "f", "force", "overwrite an existing index file");
+  try{
+    op.Parse(argv);
+  }
+  catch (...) {
+    return op.HandleMainException();
+  }
+
+  std::string infile_path = file_input.Value();
+  if(infile_path.empty()){
+    std::cout<<"option --help to get help"<<std::endl;
+    return 1;
+  }
+  std::string outfile_path = file_output.Value();
+  if(outfile_path.empty())
+    outfile_path = eudaq::EventIndex::IndexPath(infile_path);
+
+  try{
+    auto index = eudaq::EventIndex::Build(infile_path);
+    index->Save(outfile_path, overwrite.Value());
+    std::cout<< "Indexed "<< index->Size() << " events into "<< outfile_path <<std::endl;
+  }
+  catch (...) {
+    return op.HandleMainException();
+  }
+  return 0;
+}
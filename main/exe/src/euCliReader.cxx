@@ -15,13 +15,14 @@ int main(int /*argc*/, const char **argv) {
   eudaq::Option<uint32_t> timestamph(op, "TS", "timestamphigh", 0, "uint32_t", "timestamp high");
   eudaq::OptionFlag stat(op, "s", "statistics", "enable print of statistics");
   eudaq::OptionFlag stdev(op, "std", "stdevent", "enable converter of StdEvent");
+  eudaq::OptionFlag mmap(op, "m", "mmap", "memory-map the input file (native format only)");
 
   op.Parse(argv);
 
   std::string infile_path = file_input.Value();
   std::string type_in = infile_path.substr(infile_path.find_last_of(".")+1);
   if(type_in=="raw")
-    type_in = "native";
+    type_in = mmap.Value()?"mmap":"native";
 
   bool stdev_v = stdev.Value();
 
@@ -38,6 +39,29 @@ int main(int /*argc*/, const char **argv) {
   reader = eudaq::Factory<eudaq::FileReader>::MakeUnique(eudaq::str2hash(type_in), infile_path);
   uint32_t event_count = 0;
 
+  auto print_event = [stdev_v](eudaq::EventSPC ev){
+    ev->Print(std::cout);
+    if(stdev_v){
+      auto evstd = eudaq::StandardEvent::MakeShared();
+      eudaq::StdEventConverter::Convert(ev, evstd, nullptr);
+      std::cout<< ">>>>>"<< evstd->NumPlanes() <<"<<<<"<<std::endl;
+    }
+  };
+
+  auto index = reader->GetIndex();
+  if(index && not_all_zero){
+    // jump straight to the selected events instead of scanning the file
+    for(auto i: index->Select(eventl_v, eventh_v, triggerl_v, triggerh_v,
+                              timestampl_v, timestamph_v)){
+      auto ev = reader->GetEvent(i);
+      if(!ev)
+        break;
+      print_event(ev);
+    }
+    std::cout<< "There are "<< index->Size() << "Events"<<std::endl;
+    return 0;
+  }
+
   while(1){
     auto ev = reader->GetNextEvent();
     if(!ev)
@@ -75,12 +99,7 @@ int main(int /*argc*/, const char **argv) {
 
 
     if((in_range_evn && in_range_tgn && in_range_tsn) && not_all_zero){
-      ev->Print(std::cout);
-      if(stdev_v){
-        auto evstd = eudaq::StandardEvent::MakeShared();
-        eudaq::StdEventConverter::Convert(ev, evstd, nullptr);
-        std::cout<< ">>>>>"<< evstd->NumPlanes() <<"<<<<"<<std::endl;
-      }
+      print_event(ev);
     }
     
     event_count ++;
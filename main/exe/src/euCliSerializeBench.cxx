@@ -0,0 +1,123 @@
+#include "eudaq/OptionParser.hh"
+#include "eudaq/BufferSerializer.hh"
+#include "eudaq/StringDeserializer.hh"
+#include "eudaq/StandardEvent.hh"
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+namespace{
+  std::vector<eudaq::EventSPC> MakeRawEvents(uint32_t n, uint32_t bytes){
+    std::mt19937 rng(1);
+    std::vector<eudaq::EventSPC> evs;
+    for(uint32_t i = 0; i < n; i++){
+      auto ev = eudaq::Event::MakeShared("RawEvent");
+      ev->SetEventN(i);
+      ev->SetTriggerN(i);
+      ev->SetTag("Bench", std::to_string(i));
+      for(uint32_t b = 0; b < 4; b++){
+	std::vector<uint8_t> block(bytes / 4);
+	for(auto &v: block)
+	  v = rng();
+	ev->AddBlock(b, block);
+      }
+      evs.push_back(ev);
+    }
+    return evs;
+  }
+
+  std::vector<eudaq::EventSPC> MakeStdEvents(uint32_t n, uint32_t planes,
+					      uint32_t hits, bool compact){
+    std::mt19937 rng(1);
+    std::vector<eudaq::EventSPC> evs;
+    for(uint32_t i = 0; i < n; i++){
+      auto ev = eudaq::StandardEvent::MakeShared();
+      ev->SetEventN(i);
+      ev->SetTriggerN(i);
+      if(compact)
+	ev->SetFlagCompact();
+      for(uint32_t p = 0; p < planes; p++){
+	eudaq::StandardPlane plane(p, "NI", "MIMOSA26");
+	plane.SetSizeZS(1152, 576, hits);
+	for(uint32_t h = 0; h < hits; h++)
+	  plane.SetPixel(h, rng() % 1152, rng() % 576, 1);
+	ev->AddPlane(plane);
+      }
+      evs.push_back(ev);
+    }
+    return evs;
+  }
+
+  // serializes the events and reads them back, as a receiver does from a
+  // packet and as a BufferSerializer does in place
+  void RoundTrip(const std::string &name, const std::vector<eudaq::EventSPC> &evs,
+		 uint32_t repeat){
+    double best_ser = 0, best_des = 0, best_buf = 0;
+    uint64_t bytes = 0;
+    for(uint32_t r = 0; r < repeat; r++){
+      std::vector<std::string> pkts;
+      pkts.reserve(evs.size());
+      bytes = 0;
+      auto t0 = std::chrono::steady_clock::now();
+      for(auto &ev: evs){
+	eudaq::BufferSerializer ser;
+	ev->Serialize(ser);
+	bytes += ser.size();
+	pkts.emplace_back(reinterpret_cast<const char*>(&ser[0]), ser.size());
+      }
+      auto t1 = std::chrono::steady_clock::now();
+      uint64_t n = 0;
+      for(auto &pkt: pkts){
+	eudaq::StringDeserializer ds(std::move(pkt));
+	uint32_t id;
+	ds.PreRead(id);
+	auto ev = eudaq::Factory<eudaq::Event>::MakeUnique<eudaq::Deserializer&>(id, ds);
+	n += ev ?1 :0;
+      }
+      auto t2 = std::chrono::steady_clock::now();
+      for(auto &ev: evs){
+	eudaq::BufferSerializer ser;
+	ev->Serialize(ser);
+	uint32_t id;
+	ser.PreRead(id);
+	auto back = eudaq::Factory<eudaq::Event>::MakeUnique<eudaq::Deserializer&>(id, ser);
+	n += back ?1 :0;
+      }
+      auto t3 = std::chrono::steady_clock::now();
+      if(n != 2 * evs.size()){
+	std::cout << name << ": events were not read back" << std::endl;
+	return;
+      }
+      double ser_s = std::chrono::duration<double>(t1 - t0).count();
+      double des_s = std::chrono::duration<double>(t2 - t1).count();
+      double buf_s = std::chrono::duration<double>(t3 - t2).count();
+      best_ser = std::max(best_ser, evs.size() / ser_s);
+      best_des = std::max(best_des, evs.size() / des_s);
+      best_buf = std::max(best_buf, evs.size() / buf_s);
+    }
+    std::cout << name << ": " << evs.size() << " events, " << bytes / evs.size()
+	      << " bytes each, best " << uint64_t(best_ser) << " serialized/s, "
+	      << uint64_t(best_des) << " deserialized/s, "
+	      << uint64_t(best_buf) << " round trips/s" << std::endl;
+  }
+}
+
+int main(int /*argc*/, const char **argv) {
+  eudaq::OptionParser op("EUDAQ Command Line Serialize Benchmark", "2.1",
+			 "Serializes Events and StandardEvents and reads them back, reports the events/s");
+  eudaq::Option<uint32_t> eventn(op, "n", "events", 20000, "uint32_t", "number of events");
+  eudaq::Option<uint32_t> bytesn(op, "b", "bytes", 4096, "uint32_t", "bytes of data per Event");
+  eudaq::Option<uint32_t> planen(op, "l", "planes", 6, "uint32_t", "planes per StandardEvent");
+  eudaq::Option<uint32_t> hitn(op, "p", "pixels", 100, "uint32_t", "hits per plane");
+  eudaq::Option<uint32_t> repeatn(op, "r", "repeat", 5, "uint32_t", "passes over the events");
+  op.Parse(argv);
+
+  RoundTrip("Event", MakeRawEvents(eventn.Value(), bytesn.Value()), repeatn.Value());
+  RoundTrip("StandardEvent", MakeStdEvents(eventn.Value(), planen.Value(), hitn.Value(), false),
+	    repeatn.Value());
+  RoundTrip("StandardEvent compact", MakeStdEvents(eventn.Value(), planen.Value(), hitn.Value(), true),
+	    repeatn.Value());
+  return 0;
+}
@@ -0,0 +1,63 @@
+#ifndef EUDAQ_INCLUDED_AsyncFileSerializer
+#define EUDAQ_INCLUDED_AsyncFileSerializer
+
+#include "eudaq/Serializable.hh"
+#include "eudaq/BufferSerializer.hh"
+#include "eudaq/Exception.hh"
+#include "eudaq/Platform.hh"
+
+#include <string>
+#include <memory>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdio>
+
+namespace eudaq {
+  /** Writes serialized objects to a file from a dedicated I/O thread.
+   * Objects are serialized in memory into a batch, and a batch is handed
+   * over to the I/O thread once it holds flush_bytes or is older than
+   * flush_ms. The thread writes each batch with a single call and flushes
+   * the file after it. Write only blocks when more than max_pending bytes
+   * are waiting for the disk.
+   */
+  class DLLEXPORT AsyncFileSerializer {
+  public:
+    AsyncFileSerializer(const std::string &fname, bool overwrite = false,
+                        uint64_t flush_bytes = 4 << 20, uint32_t flush_ms = 1000,
+                        uint64_t max_pending = 256 << 20);
+    ~AsyncFileSerializer();
+    /// returns the offset of the object in the file
+    uint64_t Write(const Serializable &obj);
+    /// waits until everything written so far is on disk
+    void Flush();
+    uint64_t FileBytes() const { return m_accepted; }
+
+  private:
+    void HandOver(std::unique_lock<std::mutex> &lk);
+    void NewBatch();
+    void IOThread();
+    FILE *m_file;
+    std::string m_fname;
+    uint64_t m_flush_bytes;
+    std::chrono::milliseconds m_flush_ms;
+    uint64_t m_max_pending;
+    std::unique_ptr<BufferSerializer> m_front; // batch being filled
+    std::chrono::steady_clock::time_point m_front_time;
+    std::deque<std::unique_ptr<BufferSerializer>> m_queue; // batches waiting for the disk
+    uint64_t m_pending; // bytes in m_queue and being written
+    uint64_t m_accepted;
+    bool m_busy;
+    bool m_exit;
+    bool m_warned;
+    std::string m_error;
+    std::mutex m_mtx;
+    std::condition_variable m_cv_io;
+    std::condition_variable m_cv_done;
+    std::thread m_thd;
+  };
+}
+
+#endif // EUDAQ_INCLUDED_AsyncFileSerializer
@@ -6,6 +6,7 @@
 #include <iostream>
 #include "eudaq/Serializer.hh"
 #include "eudaq/Deserializer.hh"
+#include "eudaq/DataBlock.hh"
 #include "eudaq/Exception.hh"
 
 namespace eudaq {
@@ -13,26 +14,47 @@ namespace eudaq {
   class DLLEXPORT BufferSerializer
     : public Serializer, public Deserializer, public Serializable {
   public:
-    BufferSerializer() : m_offset(0) {}
+    BufferSerializer()
+      : m_data(std::make_shared<std::vector<unsigned char>>()) {
+      SetDirectBuffer();
+    }
     template <typename InIt>
     BufferSerializer(InIt first, InIt last)
-        : m_data(first, last), m_offset(0) {}
+      : m_data(std::make_shared<std::vector<unsigned char>>(first, last)) {
+      SetDirectBuffer();
+    }
+    BufferSerializer(std::vector<unsigned char> &&data)
+      : m_data(std::make_shared<std::vector<unsigned char>>(std::move(data))) {
+      SetDirectBuffer();
+    }
     BufferSerializer(Deserializer &);
+    BufferSerializer(const BufferSerializer &other);
+    BufferSerializer &operator=(const BufferSerializer &other);
+    BufferSerializer(BufferSerializer &&other);
+    BufferSerializer &operator=(BufferSerializer &&other);
     void clear() {
-      m_data.clear();
-      m_offset = 0;
+      if (m_data.use_count() > 1)
+        m_data = std::make_shared<std::vector<unsigned char>>();
+      m_data->clear();
+      m_rd_pos = 0;
+      SetDirectBuffer();
     }
-    const unsigned char &operator[](size_t i) const { return m_data[i]; }
-    size_t size() const { return m_data.size(); }
-    virtual bool HasData() { return m_data.size() != 0; }
+    const unsigned char &operator[](size_t i) const { return (*m_data)[i]; }
+    size_t size() const { return m_data->size(); }
+    virtual bool HasData() { return m_data->size() != 0; }
     virtual void Serialize(Serializer &) const;
 
   private:
     virtual void Serialize(const unsigned char *data, size_t len);
     virtual void Deserialize(unsigned char *data, size_t len);
     virtual void PreDeserialize(unsigned char *data, size_t len);
-    std::vector<unsigned char> m_data;
-    size_t m_offset;
+    virtual DataBlock DeserializeBlock(size_t len);
+    void SetDirectBuffer() {
+      Serializer::m_wr_buf = m_data.get();
+      Deserializer::m_rd_buf = m_data.get();
+    }
+    // shared with the DataBlocks sliced out of it by DeserializeBlock
+    std::shared_ptr<std::vector<unsigned char>> m_data;
   };
 }
 
@@ -0,0 +1,111 @@
+#ifndef EUDAQ_INCLUDED_CompactPlane
+#define EUDAQ_INCLUDED_CompactPlane
+
+#include "eudaq/Serializable.hh"
+#include "eudaq/Serializer.hh"
+#include "eudaq/Deserializer.hh"
+#include "eudaq/StandardPlane.hh"
+#include "eudaq/Platform.hh"
+
+#include <vector>
+#include <string>
+
+namespace eudaq {
+
+  /** Hits of a plane in structure of arrays form.
+   * Coordinates are 16 bit, the charge (or ToT) is stored with 0, 1, 2 or 4
+   * bytes per hit, where 0 bytes means every hit has the charge 1, and an
+   * optional 64 bit timestamp goes with every hit. The hits of all the
+   * frames are kept in the same arrays, frame f being the hits between
+   * offset f and f+1, so the hits have to be pushed in frame order.
+   * The flags are the ones of StandardPlane; coordinates are always kept
+   * per frame.
+   */
+  class DLLEXPORT CompactPlane : public Serializable {
+    friend class StandardPlane;
+  public:
+    static const uint32_t VERSION = 1;
+
+    /// zero-copy view of the hits of one frame
+    struct FrameView {
+      const uint16_t *x;
+      const uint16_t *y;
+      const uint8_t *charge; // nullptr if every charge is 1
+      const uint64_t *time; // nullptr without timestamps
+      const uint8_t *pivot; // nullptr without pivot flags
+      uint32_t n;
+      uint32_t charge_bytes;
+      uint32_t Charge(uint32_t i) const;
+    };
+
+    CompactPlane();
+    CompactPlane(uint32_t id, const std::string &type,
+                 const std::string &sensor = "", uint32_t charge_bytes = 2,
+                 bool with_time = false);
+    CompactPlane(Deserializer &);
+    /// throws if the plane does not fit, see Fits
+    explicit CompactPlane(const StandardPlane &);
+    void Serialize(Serializer &) const override;
+
+    /// true if all coordinates and pixel values of p are integers which fit
+    /// and frames without own coordinates have the hits of the first one
+    static bool Fits(const StandardPlane &p);
+    StandardPlane ToStandardPlane() const;
+
+    void SetSize(uint32_t w, uint32_t h, uint32_t frames = 1, int flags = 0);
+    void Reserve(uint32_t npix);
+    void PushPixel(uint16_t x, uint16_t y, uint32_t charge = 1,
+                   uint32_t frame = 0, uint64_t time = 0, bool pivot = false);
+    /// appends n hits of charge 1 to frame, pivot may be nullptr
+    void PushPixels(uint32_t frame, const uint16_t *x, const uint16_t *y,
+                    uint32_t n, const uint8_t *pivot = nullptr);
+    FrameView Frame(uint32_t frame = 0) const;
+
+    uint32_t ID() const {return m_id;};
+    const std::string &Type() const {return m_type;};
+    const std::string &Sensor() const {return m_sensor;};
+    uint32_t XSize() const {return m_xsize;};
+    uint32_t YSize() const {return m_ysize;};
+    uint32_t NumFrames() const {return m_offset.size() - 1;};
+    uint32_t HitPixels(uint32_t frame) const;
+    uint32_t HitPixels() const {return m_x.size();};
+    uint32_t PivotPixel() const {return m_pivotpixel;};
+    void SetPivotPixel(uint32_t p) {m_pivotpixel = p;};
+    uint32_t ChargeBytes() const {return m_charge_bytes;};
+    bool HasTime() const {return m_with_time;};
+    int GetFlags(int f) const {return m_flags & f;};
+    int Polarity() const;
+
+    double GetX(uint32_t index, uint32_t frame = 0) const;
+    double GetY(uint32_t index, uint32_t frame = 0) const;
+    double GetPixel(uint32_t index, uint32_t frame = 0) const;
+    bool GetPivot(uint32_t index, uint32_t frame = 0) const;
+    uint64_t GetTime(uint32_t index, uint32_t frame = 0) const;
+
+    /// bytes held by the hit arrays
+    size_t HitBytes() const;
+    void Print(std::ostream &os, size_t offset = 0) const;
+
+  private:
+    void Unpack(StandardPlane &p) const;
+    uint32_t At(uint32_t index, uint32_t frame) const;
+
+    std::string m_type;
+    std::string m_sensor;
+    uint32_t m_id;
+    uint32_t m_xsize;
+    uint32_t m_ysize;
+    uint32_t m_flags;
+    uint32_t m_pivotpixel;
+    uint32_t m_charge_bytes;
+    bool m_with_time;
+    std::vector<uint32_t> m_offset; // frames + 1 entries
+    std::vector<uint16_t> m_x, m_y;
+    std::vector<uint8_t> m_charge; // m_charge_bytes per hit, little endian
+    std::vector<uint64_t> m_time;
+    std::vector<uint8_t> m_pivot; // with FLAG_WITHPIVOT only
+    std::vector<uint32_t> m_mat;
+  };
+}
+
+#endif // EUDAQ_INCLUDED_CompactPlane
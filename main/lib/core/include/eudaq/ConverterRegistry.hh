@@ -0,0 +1,203 @@
+#ifndef EUDAQ_INCLUDED_ConverterRegistry
+#define EUDAQ_INCLUDED_ConverterRegistry
+
+#include "eudaq/Factory.hh"
+#include "eudaq/Configuration.hh"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <map>
+#include <memory>
+#include <cstdint>
+
+namespace eudaq {
+
+  /** Converters created once and shared, instead of one per event.
+   * The converters registered in Factory<BASE> are looked up through a flat
+   * open addressing table keyed by the type or extend word; the table and
+   * the converters are immutable once published, so Get takes no lock
+   * unless a converter is used the first time. A converter instance is
+   * made for every configuration object it is used with and Configure is
+   * called on it before it is published; this is where per run state such
+   * as parsed parameters belongs. The configuration is not kept alive, the
+   * converters of released configurations are reaped when the next one is
+   * made, so a converter is only to be used while its configuration is
+   * held. The instances are shared between threads, Converting must stay
+   * free of unguarded state.
+   */
+  template <typename BASE> class ConverterRegistry {
+  public:
+    /// the converter of type id for conf, nullptr if there is none
+    static const BASE *Get(uint32_t id, const ConfigurationSPC &conf) {
+      return Instance().Find(id, conf);
+    }
+
+  private:
+    using Maker = typename Factory<BASE>::UP_BASE (*)();
+    struct Converter {
+      // matched by owner, the control block outlives the configuration
+      std::weak_ptr<const Configuration> conf;
+      bool with_conf;
+      typename Factory<BASE>::UP_BASE cvt;
+      std::atomic<Converter *> next;
+    };
+    struct Slot {
+      uint32_t id;
+      Maker maker; // nullptr for a type nobody registered
+      std::atomic<Converter *> head{nullptr};
+    };
+    struct Table {
+      std::vector<std::pair<uint32_t, Slot *>> entries;
+      uint32_t shift;
+      size_t registered_n;
+    };
+
+    // never destroyed: converters may still be in use by other threads and
+    // their code may live in modules when the statics go away
+    static ConverterRegistry &Instance() {
+      static ConverterRegistry *reg = new ConverterRegistry;
+      return *reg;
+    }
+
+    ConverterRegistry() : m_table(nullptr), m_registered_n(0), m_readers(0) {}
+
+    static uint32_t Hash(uint32_t id, uint32_t shift) {
+      return uint32_t(id * 0x9E3779B1u) >> shift;
+    }
+
+    static Slot *Lookup(const Table &t, uint32_t id) {
+      uint32_t mask = t.entries.size() - 1;
+      for (uint32_t h = Hash(id, t.shift);; h = (h + 1) & mask) {
+        auto &e = t.entries[h];
+        if (!e.second || e.first == id)
+          return e.second;
+      }
+    }
+
+    static bool Same(const Converter &c, const ConfigurationSPC &conf) {
+      if (!conf)
+        return !c.with_conf;
+      return c.with_conf && !c.conf.owner_before(conf) && !conf.owner_before(c.conf);
+    }
+
+    static const BASE *Match(const Slot &s, const ConfigurationSPC &conf) {
+      for (Converter *c = s.head.load(std::memory_order_acquire); c;
+           c = c->next.load(std::memory_order_acquire))
+        if (Same(*c, conf))
+          return c->cvt.get();
+      return nullptr;
+    }
+
+    const BASE *Find(uint32_t id, const ConfigurationSPC &conf) {
+      Table *t = m_table.load(std::memory_order_acquire);
+      if (t) {
+        // the lists are walked without the lock, Reap frees no converter
+        // while somebody does
+        m_readers++;
+        Slot *s = Lookup(*t, id);
+        const BASE *cvt = nullptr;
+        bool none = false;
+        if (s && s->maker)
+          cvt = Match(*s, conf);
+        else if (s && t->registered_n == Factory<BASE>::template Instance<>().size())
+          none = true;
+        m_readers--;
+        if (cvt || none)
+          return cvt;
+      }
+      return Create(id, conf);
+    }
+
+    const BASE *Create(uint32_t id, const ConfigurationSPC &conf) {
+      std::unique_lock<std::mutex> lk(m_mtx);
+      auto &makers = Factory<BASE>::template Instance<>();
+      Table *t = m_table.load(std::memory_order_relaxed);
+      // modules loaded later may have registered more converters
+      if (!t || makers.size() != m_registered_n || !m_slots.count(id)) {
+        for (auto &e : makers) {
+          auto &s = m_slots[e.first];
+          if (!s) {
+            s.reset(new Slot);
+            s->id = e.first;
+          }
+          s->maker = e.second;
+        }
+        auto &s = m_slots[id];
+        if (!s) {
+          s.reset(new Slot);
+          s->id = id;
+          s->maker = nullptr;
+        }
+        m_registered_n = makers.size();
+        Publish();
+      }
+      Slot &s = *m_slots[id];
+      if (!s.maker)
+        return nullptr;
+      const BASE *cvt = Match(s, conf);
+      if (cvt)
+        return cvt;
+      Reap();
+      std::unique_ptr<Converter> c(new Converter);
+      c->conf = conf;
+      c->with_conf = bool(conf);
+      c->cvt = s.maker();
+      c->cvt->Configure(conf);
+      c->next.store(s.head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+      cvt = c->cvt.get();
+      s.head.store(c.release(), std::memory_order_release);
+      return cvt;
+    }
+
+    // unlinks the converters of released configurations, they are freed
+    // once no reader may still be on the lists
+    void Reap() {
+      for (auto &e : m_slots) {
+        std::atomic<Converter *> *prev = &e.second->head;
+        for (Converter *c = prev->load(); c;) {
+          Converter *n = c->next.load();
+          if (c->with_conf && c->conf.expired()) {
+            prev->store(n);
+            m_retired.emplace_back(c);
+          }
+          else
+            prev = &c->next;
+          c = n;
+        }
+      }
+      if (!m_retired.empty() && m_readers == 0)
+        m_retired.clear();
+    }
+
+    void Publish() {
+      uint32_t bits = 3;
+      while ((size_t(1) << bits) < m_slots.size() * 2)
+        bits++;
+      std::unique_ptr<Table> t(new Table);
+      t->entries.assign(size_t(1) << bits, std::make_pair(0u, (Slot *)nullptr));
+      t->shift = 32 - bits;
+      t->registered_n = m_registered_n;
+      uint32_t mask = t->entries.size() - 1;
+      for (auto &e : m_slots) {
+        uint32_t h = Hash(e.first, t->shift);
+        while (t->entries[h].second)
+          h = (h + 1) & mask;
+        t->entries[h] = std::make_pair(e.first, e.second.get());
+      }
+      m_table.store(t.get(), std::memory_order_release);
+      // readers may still walk the old tables
+      m_tables.push_back(std::move(t));
+    }
+
+    std::mutex m_mtx;
+    std::atomic<Table *> m_table;
+    std::vector<std::unique_ptr<Table>> m_tables;
+    std::map<uint32_t, std::unique_ptr<Slot>> m_slots;
+    size_t m_registered_n;
+    std::atomic<uint32_t> m_readers;
+    std::vector<std::unique_ptr<Converter>> m_retired;
+  };
+}
+
+#endif // EUDAQ_INCLUDED_ConverterRegistry
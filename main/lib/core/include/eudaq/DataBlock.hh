@@ -0,0 +1,76 @@
+#ifndef EUDAQ_INCLUDED_DataBlock
+#define EUDAQ_INCLUDED_DataBlock
+
+#include "eudaq/Serializable.hh"
+#include "eudaq/Serializer.hh"
+#include "eudaq/Deserializer.hh"
+#include "eudaq/Platform.hh"
+
+#include <vector>
+#include <memory>
+
+namespace eudaq {
+
+  /** A non-owning view of a contiguous range of bytes.
+   * It is only valid as long as the owner of the memory (e.g. the Event
+   * holding the block) is alive.
+   */
+  class BlockView {
+  public:
+    using value_type = uint8_t;
+    using const_iterator = const uint8_t *;
+    BlockView() : m_data(nullptr), m_size(0) {}
+    BlockView(const uint8_t *data, size_t size) : m_data(data), m_size(size) {}
+    const uint8_t *data() const { return m_data; }
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    const uint8_t *begin() const { return m_data; }
+    const uint8_t *end() const { return m_data + m_size; }
+    const uint8_t &operator[](size_t i) const { return m_data[i]; }
+    BlockView subview(size_t offset, size_t size) const {
+      if (offset > m_size || size > m_size - offset)
+        EUDAQ_THROW("BlockView:: " + std::to_string(size) + " bytes at " +
+                    std::to_string(offset) + " exceed a view of " +
+                    std::to_string(m_size));
+      return BlockView(m_data + offset, size);
+    }
+  private:
+    const uint8_t *m_data;
+    size_t m_size;
+  };
+
+  /** A reference-counted, immutable slice of a byte buffer.
+   * Copying a DataBlock only copies the reference, never the payload.
+   * Several blocks may share the same underlying buffer, e.g. all blocks
+   * deserialized from one received packet.
+   */
+  class DLLEXPORT DataBlock : public Serializable {
+  public:
+    DataBlock();
+    DataBlock(std::vector<uint8_t> &&data);
+    DataBlock(const uint8_t *data, size_t size);
+    DataBlock(std::shared_ptr<const std::vector<uint8_t>> buf,
+              size_t offset, size_t size);
+    /// slice of memory kept alive by the (possibly aliasing) shared pointer
+    DataBlock(std::shared_ptr<const uint8_t> ptr, size_t size);
+    explicit DataBlock(Deserializer &ds);
+    void Serialize(Serializer &ser) const override;
+
+    const uint8_t *data() const { return m_ptr.get(); }
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    const uint8_t *begin() const { return m_ptr.get(); }
+    const uint8_t *end() const { return m_ptr.get() + m_size; }
+    const uint8_t &operator[](size_t i) const { return m_ptr.get()[i]; }
+    BlockView View() const { return BlockView(m_ptr.get(), m_size); }
+    std::vector<uint8_t> ToVector() const {
+      return std::vector<uint8_t>(begin(), end());
+    }
+
+  private:
+    std::shared_ptr<const uint8_t> m_ptr;
+    size_t m_size;
+  };
+}
+
+#endif // EUDAQ_INCLUDED_DataBlock
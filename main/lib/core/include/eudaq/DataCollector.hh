@@ -43,7 +43,11 @@ namespace eudaq {
     virtual void DoConnect(ConnectionSPC id);
     virtual void DoDisconnect(ConnectionSPC id);
     virtual void DoReceive(ConnectionSPC id, EventSP ev);
+    /// by default the events are given to DoReceive one by one
+    virtual void DoReceiveEvents(ConnectionSPC id, std::vector<EventSP> &evs);
     void WriteEvent(EventSP ev);
+    /// writes and samples a batch of events at once, evs is emptied
+    void WriteEvents(std::vector<EventSP> &evs);
     void SetServerAddress(const std::string &addr);
     static DataCollectorSP Make(const std::string &code_name,
 				const std::string &run_name,
@@ -59,11 +63,19 @@ namespace eudaq {
     void OnConnect(ConnectionSPC id) override final;
     void OnDisconnect(ConnectionSPC id) override final;
     void OnReceive(ConnectionSPC id, EventSP ev) override final;
+    void OnReceiveEvents(ConnectionSPC id, std::vector<EventSP> &evs) override final;
+    void StampEvent(Event &ev);
   private:
+    struct MonitorSender {
+      std::string name;
+      std::shared_ptr<DataSender> sender;
+      uint32_t fraction; // every n-th event is sent, none if zero
+    };
+    using MonitorSenders = std::vector<MonitorSender>;
     std::string m_data_addr;
     FileWriterSP m_writer;
     std::mutex m_mtx_sender;
-    std::map<std::string, std::shared_ptr<DataSender>> m_senders;
+    std::shared_ptr<const MonitorSenders> m_senders; // replaced, never modified
     std::string m_fwpatt;
     std::string m_fwtype;
     uint32_t m_dct_n;
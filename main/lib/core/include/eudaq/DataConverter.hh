@@ -23,6 +23,9 @@ namespace eudaq{
     DataConverter& operator = (const DataConverter &) = delete;
     virtual ~DataConverter(){};
     virtual bool Converting(T1SPC d1, T2SP d2, ConfigurationSPC conf) const = 0;
+    /// called once before the converter is used with conf, the state derived
+    /// from conf can be cached here, see ConverterRegistry
+    virtual void Configure(ConfigurationSPC /*conf*/){};
   };
 }
 #endif
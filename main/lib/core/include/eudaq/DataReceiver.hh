@@ -10,9 +10,11 @@
 #include "eudaq/Utils.hh"
 #include "eudaq/Platform.hh"
 #include "eudaq/Factory.hh"
+#include "eudaq/LockFreeQueue.hh"
 
 #include <string>
 #include <vector>
+#include <map>
 #include <list>
 #include <memory>
 #include <atomic>
@@ -35,13 +37,53 @@ namespace eudaq {
     virtual void OnConnect(ConnectionSPC id);
     virtual void OnDisconnect(ConnectionSPC id);
     virtual void OnReceive(ConnectionSPC id, EventSP ev);
+    /// Events of one connection which were waiting together, in order; by
+    /// default given to OnReceive one by one
+    virtual void OnReceiveEvents(ConnectionSPC id, std::vector<EventSP> &evs);
     std::string Listen(const std::string &addr);
     void StopListen();//TODO: remove this method later
+    /** Sets what happens once more than max_bytes of data of one connection
+     * are waiting to be handled:
+     * "drop": newly received events are discarded,
+     * "block": reading from the connection stops until half of it has been
+     * handled, so the sender is slowed down by TCP flow control,
+     * "spill": newly received data goes to a file in spill_dir and is read
+     * back in order once the connection has no events waiting any more.
+     */
+    void SetFlowControl(const std::string &mode, uint64_t max_bytes,
+                        const std::string &spill_dir = "");
+    /// Queued events and bytes per connection, to be used as status tags
+    std::map<std::string, std::string> GetQueueStatus() const;
+    /** Number of threads decoding the received packets, taking effect at the
+     * next Listen. With 0 the packets are decoded by the thread calling
+     * OnReceive, a negative number picks one thread per spare core (at most
+     * 4). The events are handed over in the order they were received in
+     * either case.
+     */
+    void SetDecodeThreads(int n);
   private:
+    enum FlowMode {FLOW_DROP, FLOW_BLOCK, FLOW_SPILL};
+    struct Flow;
+    struct Packet;
+    struct Item{
+      std::shared_ptr<Packet> pkt;
+      ConnectionSPC con;
+      std::shared_ptr<Flow> flow;
+      uint64_t bytes;
+    };
     void DataHandler(TransportEvent &ev);
     bool Deamon();
     bool AsyncReceiving();
     bool AsyncForwarding();
+    void AsyncDecoding();
+    void Decode(Packet &pkt);
+    EventSP Decoded(Packet &pkt);
+    void Dispatch(std::shared_ptr<Packet> pkt);
+    void Receive(ConnectionSPC con, std::string &&packet);
+    void Release(const Item &item);
+    void Reload(ConnectionSPC con, std::shared_ptr<Flow> flow);
+    void ReloadSpills();
+    void PushHeld();
     
   private:
     std::unique_ptr<TransportServer> m_dataserver;
@@ -53,10 +95,21 @@ namespace eudaq {
     std::future<bool> m_fut_async_rcv;
     std::future<bool> m_fut_async_fwd;
     std::future<bool> m_fut_deamon;
-    std::mutex m_mx_qu_ev;
     std::mutex m_mx_deamon;
-    std::queue<std::pair<EventSP, ConnectionSPC>> m_qu_ev;
-    std::condition_variable m_cv_not_empty;
+    LockFreeQueue<Item> m_qu_ev;
+    FlowMode m_flow_mode;
+    uint64_t m_flow_bytes;
+    std::string m_spill_dir;
+    mutable std::mutex m_mx_flow;
+    std::map<const ConnectionInfo*, std::pair<ConnectionSPC, std::shared_ptr<Flow>>> m_flows;
+    std::atomic<int> m_spill_active;
+    std::atomic<int> m_held_active;
+    uint32_t m_dec_n;
+    std::vector<std::thread> m_th_dec;
+    LockFreeQueue<std::shared_ptr<Packet>> m_qu_dec;
+    std::atomic<bool> m_dec_wait;
+    std::mutex m_mx_dec;
+    std::condition_variable m_cv_dec;
   };
   //----------DOC-MARK-----END*DEC-----DOC-MARK----------
 }
@@ -4,12 +4,15 @@
 
 #include "eudaq/Platform.hh"
 #include "eudaq/Event.hh"
+#include "eudaq/LockFreeQueue.hh"
 #include <string>
 #include <future>
 #include <thread>
 #include <queue>
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
+#include <chrono>
 
 namespace eudaq {
 
@@ -19,18 +22,32 @@ class TransportClient;
   public:
       DataSender(const std::string & type, const std::string & name);
       ~DataSender();
+      /// Before Connect: with a depth, SendEvent only queues the event and
+      /// a thread sends it, a full queue discards the "newest" or the
+      /// "oldest" event instead of waiting. Without, SendEvent sends itself.
+      /// On destruction the queue is sent for up to drain_ms, the rest of
+      /// it is counted as dropped.
+      void SetQueue(size_t depth, const std::string &drop = "oldest",
+		    uint32_t drain_ms = 1000);
       void Connect(const std::string & server);
       void SendEvent(EventSPC ev);
+      uint64_t GetSentN() const {return m_packetCounter;};
+      uint64_t GetDroppedN() const {return m_n_dropped;};
+      size_t GetQueuedN() const {return m_qu_ev ?m_qu_ev->Size() :0;};
   private:
       bool AsyncSending();
+      void StopSending();
+      void Drop();
       std::string m_type, m_name;
       std::unique_ptr<TransportClient> m_dataclient;
-      uint64_t m_packetCounter;
+      std::atomic<uint64_t> m_packetCounter;
+      std::atomic<uint64_t> m_n_dropped;
       std::future<bool> m_fut_async;
-      bool m_is_connected;
-      std::mutex m_mx_qu_ev; 
-      std::queue<EventSPC> m_qu_ev;
-      std::condition_variable m_cv_not_empty;
+      std::atomic<bool> m_is_connected;
+      std::unique_ptr<LockFreeQueue<EventSPC>> m_qu_ev;
+      bool m_drop_oldest;
+      std::chrono::milliseconds m_drain;
+      std::chrono::steady_clock::time_point m_drain_end;
   };
 
 }
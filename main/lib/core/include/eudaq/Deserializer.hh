@@ -9,8 +9,11 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <cstring>
 
 namespace eudaq{
+  class DataBlock;
+
   class DLLEXPORT Deserializer {
   public:
     Deserializer();
@@ -33,17 +36,44 @@ namespace eudaq{
     }
       
     void read(unsigned char *dst, size_t size);
+    DataBlock ReadBlock(size_t size);
     void PreRead(uint32_t &t);
     void PreRead(uint8_t *dst, size_t size);
   protected:
     bool m_interrupting;
+    /// if m_rd_data is set, read() takes the data from its m_rd_size bytes,
+    /// starting at m_rd_pos, without the virtual call; a buffer which may
+    /// grow sets m_rd_buf instead, which they are taken from on every read
+    const std::vector<uint8_t> *m_rd_buf;
+    const uint8_t *m_rd_data;
+    size_t m_rd_size;
+    size_t m_rd_pos;
 
   private:
     template <typename T> friend struct ReadHelper;
     virtual void Deserialize(unsigned char *, size_t) = 0;
     virtual void PreDeserialize(unsigned char *, size_t) = 0;
+    virtual DataBlock DeserializeBlock(size_t);
+    template <typename T>
+    void read_elements(std::vector<T> &t, size_t len, std::true_type);
+    template <typename T>
+    void read_elements(std::vector<T> &t, size_t len, std::false_type);
   };
 
+  inline void Deserializer::read(unsigned char *dst, size_t size) {
+    if (m_rd_buf) {
+      m_rd_data = m_rd_buf->data();
+      m_rd_size = m_rd_buf->size();
+    }
+    if (m_rd_data && m_rd_size - m_rd_pos >= size) {
+      if (size)
+        std::memcpy(dst, m_rd_data + m_rd_pos, size);
+      m_rd_pos += size;
+    }
+    else
+      Deserialize(dst, size);
+  }
+
   template <typename T> struct ReadHelper {
     typedef T (*reader)(Deserializer &ser);
     static reader GetFunc(Serializable *) { return read_ser; }
@@ -62,7 +92,7 @@ namespace eudaq{
     static T read_ser(Deserializer &ds) { return T(ds); }
     static T read_char(Deserializer &ds) {
       unsigned char buf[sizeof(char)];
-      ds.Deserialize(buf, sizeof(char));
+      ds.read(buf, sizeof(char));
       T t = buf[0];
       return t;
     }
@@ -71,33 +101,50 @@ namespace eudaq{
       // behaviour in bit shift below
       static_assert(sizeof(T) > 1, "Called read_int() in Serializer.hh which "
                                    "only supports integers of size > 1 byte!");
+#if EUDAQ_LITTLE_ENDIAN
+      T t;
+      ds.read(reinterpret_cast<unsigned char *>(&t), sizeof t);
+      return t;
+#else
       unsigned char buf[sizeof(T)];
-      ds.Deserialize(buf, sizeof(T));
+      ds.read(buf, sizeof(T));
       T t = 0;
       for (size_t i = 0; i < sizeof t; ++i) {
         t <<= 8;
         t += buf[sizeof t - 1 - i];
       }
       return t;
+#endif
     }
     static float read_float(Deserializer &ds) {
+#if EUDAQ_LITTLE_ENDIAN
+      float f;
+      ds.read(reinterpret_cast<unsigned char *>(&f), sizeof f);
+      return f;
+#else
       unsigned char buf[sizeof(float)];
-      ds.Deserialize(buf, sizeof buf);
+      ds.read(buf, sizeof buf);
       unsigned t = 0;
       for (size_t i = 0; i < sizeof t; ++i) {
         t <<= 8;
         t += buf[sizeof t - 1 - i];
       }
       return *(float *)&t;
+#endif
     }
     static double read_double(Deserializer &ds) {
+#if EUDAQ_LITTLE_ENDIAN
+      double d;
+      ds.read(reinterpret_cast<unsigned char *>(&d), sizeof d);
+      return d;
+#else
       union {
         double d;
         uint64_t i;
         unsigned char b[sizeof(double)];
       } u;
       // unsigned char buf[sizeof (double)];
-      ds.Deserialize(u.b, sizeof u.b);
+      ds.read(u.b, sizeof u.b);
       uint64_t t = 0;
       for (size_t i = 0; i < sizeof t; ++i) {
         t <<= 8;
@@ -105,6 +152,7 @@ namespace eudaq{
       }
       u.i = t;
       return u.d;
+#endif
     }
   };
 
@@ -117,7 +165,7 @@ namespace eudaq{
     read(len);
     t = std::string(len, ' ');
     if (len)
-      Deserialize(reinterpret_cast<unsigned char *>(&t[0]), len);
+      read(reinterpret_cast<unsigned char *>(&t[0]), len);
   }
 
   template <> inline void Deserializer::read(Time &t) {
@@ -130,6 +178,19 @@ namespace eudaq{
   template <typename T> inline void Deserializer::read(std::vector<T> &t) {
     unsigned len = 0;
     read(len);
+    read_elements(t, len, is_bulk_serializable<T>());
+  }
+
+  template <typename T>
+  inline void Deserializer::read_elements(std::vector<T> &t, size_t len,
+                                          std::true_type) {
+    t.resize(len);
+    read(reinterpret_cast<unsigned char *>(t.data()), len * sizeof(T));
+  }
+
+  template <typename T>
+  inline void Deserializer::read_elements(std::vector<T> &t, size_t len,
+                                          std::false_type) {
     t.reserve(len);
     for (size_t i = 0; i < len; ++i) {
       t.push_back(read<T>());
@@ -141,14 +202,14 @@ namespace eudaq{
     unsigned len = 0;
     read(len);
     t.resize(len);
-    Deserialize(&t[0], len);
+    read(t.data(), len);
   }
 
   template <> inline void Deserializer::read<char>(std::vector<char> &t) {
     unsigned len = 0;
     read(len);
     t.resize(len);
-    Deserialize(reinterpret_cast<unsigned char *>(&t[0]), len);
+    read(reinterpret_cast<unsigned char *>(t.data()), len);
   }
 
   template <typename T, typename U>
@@ -9,6 +9,7 @@
 #include "eudaq/Serializable.hh"
 #include "eudaq/Serializer.hh"
 #include "eudaq/Deserializer.hh"
+#include "eudaq/DataBlock.hh"
 #include "eudaq/Exception.hh"
 #include "eudaq/Utils.hh"
 #include "eudaq/Platform.hh"
@@ -40,7 +41,8 @@ namespace eudaq {
       FLAG_FAKE = 0x4,
       FLAG_PACK = 0x8,
       FLAG_TRIG = 0x10,
-      FLAG_TIME = 0x20
+      FLAG_TIME = 0x20,
+      FLAG_COMP = 0x40
     };
 
     Event();
@@ -116,6 +118,9 @@ namespace eudaq {
 
     //from RawdataEvent
     std::vector<uint8_t> GetBlock(uint32_t i) const;
+    /// Access a data block without copying, valid as long as the Event lives
+    BlockView GetBlockView(uint32_t i) const;
+    DataBlock GetDataBlock(uint32_t i) const;
     size_t GetNumBlock() const;
     size_t NumBlocks() const;
     std::vector<uint32_t> GetBlockNumList() const;
@@ -123,22 +128,31 @@ namespace eudaq {
     /// Add a data block as std::vector
     template <typename T>
     size_t AddBlock(uint32_t id, const std::vector<T> &data){
-      m_blocks[id]=make_vector(data);
+      m_blocks[id]=DataBlock(make_vector(data));
       return m_blocks.size();
     }
 
     /// Add a data block as array with given size
     template <typename T>
     size_t AddBlock(uint32_t id, const T *data, size_t bytes){
-      m_blocks[id]=make_vector(data, bytes);
+      m_blocks[id]=DataBlock(make_vector(data, bytes));
       return m_blocks.size();
     }
 
+    /// Add a data block by taking over the memory of the vector
+    size_t AddBlock(uint32_t id, std::vector<uint8_t> &&data);
+    /// Add a data block sharing the memory of the given DataBlock
+    size_t AddBlock(uint32_t id, DataBlock data);
+
     template <typename T>
     void AppendBlock(size_t index, const std::vector<T> &data) {
       auto &&src = make_vector(data);
-      auto &&dst = m_blocks[index];
-      dst.insert(dst.end(), src.begin(), src.end());
+      auto &dst = m_blocks[index];
+      std::vector<uint8_t> buf;
+      buf.reserve(dst.size() + src.size());
+      buf.insert(buf.end(), dst.begin(), dst.end());
+      buf.insert(buf.end(), src.begin(), src.end());
+      dst = DataBlock(std::move(buf));
     }
 
     //TODO: remove, clearn up
@@ -176,7 +190,7 @@ namespace eudaq {
     uint64_t m_ts_end;
     std::string m_dspt;
     std::map<std::string, std::string> m_tags;
-    std::map<uint32_t, std::vector<uint8_t>> m_blocks;
+    std::map<uint32_t, DataBlock> m_blocks;
     std::vector<EventSPC> m_sub_events;
   };
 }
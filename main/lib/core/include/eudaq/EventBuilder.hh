@@ -0,0 +1,105 @@
+#ifndef EUDAQ_INCLUDED_EventBuilder
+#define EUDAQ_INCLUDED_EventBuilder
+
+#include "eudaq/Event.hh"
+#include "eudaq/Platform.hh"
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <chrono>
+#include <functional>
+
+namespace eudaq {
+
+  /** Merges the fragments of several streams by a key (trigger or event
+   * number) which increases within each stream.
+   * The head of every non-empty stream sits in a min-heap, so building an
+   * event costs O(log N) per fragment, independent of the number of
+   * streams. An event is built as soon as every active stream holds a
+   * fragment; the fragments carrying the lowest key go into it, a stream
+   * whose head has a higher key missed that event.
+   * While a stream is empty the building stalls, unless the oldest waiting
+   * fragment is older than the timeout or a stream holds more than
+   * max_queue fragments. The policy then decides what to do with the
+   * incomplete event. Not thread safe.
+   */
+  class DLLEXPORT EventBuilder {
+  public:
+    enum MissingPolicy {
+      MISSING_WAIT, // never give up on empty streams
+      MISSING_PARTIAL, // build events without the missing fragments
+      MISSING_DROP // discard incomplete events
+    };
+    struct Built {
+      uint64_t key;
+      std::vector<EventSPC> frags;
+      uint32_t missing; // active streams without a fragment for this key
+    };
+
+    EventBuilder();
+    /// "wait", "partial" or "drop"
+    static MissingPolicy ParsePolicy(const std::string &policy);
+    /// a zero timeout or max_queue does not force any building
+    void Configure(MissingPolicy policy, uint32_t timeout_ms, size_t max_queue);
+
+    uint32_t AddStream(const std::string &name);
+    /// With drain, the queued fragments of the stream still go into events.
+    void RemoveStream(uint32_t id, bool drain);
+    /// false if the fragment is late, i.e. its key was already built or is
+    /// not above the last one of the stream; it is discarded then
+    bool Push(uint32_t id, uint64_t key, EventSPC ev);
+    /// Takes the next event which can be built now
+    bool Next(Built &out);
+    /// Drops all the queued fragments, the streams are kept
+    void Clear();
+
+    size_t GetStreamN() const {return m_n_streams;};
+    size_t GetPendingN() const {return m_n_pending;};
+    size_t GetPendingN(uint32_t id) const;
+    uint64_t GetBuiltN() const {return m_n_built;};
+    uint64_t GetIncompleteN() const {return m_n_incomplete;};
+    uint64_t GetDroppedN() const {return m_n_dropped;};
+    uint64_t GetLateN() const {return m_n_late;};
+
+  private:
+    using Clock = std::chrono::steady_clock;
+    struct Frag {
+      uint64_t key;
+      EventSPC ev;
+      Clock::time_point t;
+    };
+    struct Stream {
+      std::string name;
+      std::deque<Frag> que;
+      bool used;
+      bool active;
+    };
+    using Head = std::pair<uint64_t, uint32_t>; // key of the front, stream
+
+    bool Forced();
+    Frag PopFront(uint32_t id);
+    void Erase(uint32_t id);
+    void RebuildHeap();
+
+    std::vector<Stream> m_streams;
+    std::vector<uint32_t> m_free;
+    std::vector<Head> m_heap; // std::greater ordered, lowest key on top
+    size_t m_n_streams;
+    size_t m_n_active;
+    size_t m_n_empty; // active streams without fragments
+    size_t m_n_over; // streams holding more than m_max_queue fragments
+    size_t m_n_pending;
+    bool m_has_last;
+    uint64_t m_last_key;
+    MissingPolicy m_policy;
+    Clock::duration m_timeout;
+    size_t m_max_queue;
+    uint64_t m_n_built;
+    uint64_t m_n_incomplete;
+    uint64_t m_n_dropped;
+    uint64_t m_n_late;
+  };
+}
+
+#endif // EUDAQ_INCLUDED_EventBuilder
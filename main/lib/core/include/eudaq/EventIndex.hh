@@ -0,0 +1,69 @@
+#ifndef EUDAQ_INCLUDED_EventIndex
+#define EUDAQ_INCLUDED_EventIndex
+
+#include "eudaq/Event.hh"
+#include "eudaq/FileSerializer.hh"
+#include "eudaq/Platform.hh"
+
+#include <vector>
+#include <string>
+#include <memory>
+
+namespace eudaq {
+  class EventIndex;
+  using EventIndexSP = std::shared_ptr<EventIndex>;
+  using EventIndexSPC = std::shared_ptr<const EventIndex>;
+
+  /** Sidecar index of a native .raw file, stored next to it as <file>.idx.
+   * It holds one entry per top level event, so that a reader can jump to an
+   * event, trigger number or timestamp range without deserializing the
+   * whole file.
+   */
+  class DLLEXPORT EventIndex {
+  public:
+    struct Entry {
+      uint64_t offset; // byte offset of the event in the raw file
+      uint32_t event_n;
+      uint32_t trigger_n;
+      uint64_t ts_begin;
+      uint64_t ts_end;
+      uint32_t flags;
+    };
+
+    static std::string IndexPath(const std::string &raw_path);
+    static Entry MakeEntry(const Event &ev, uint64_t offset);
+    /// returns nullptr if there is no index or it does not match the raw file
+    static EventIndexSP Open(const std::string &raw_path);
+    static EventIndexSP Load(const std::string &idx_path);
+    /// scans a raw file and creates the index of it
+    static EventIndexSP Build(const std::string &raw_path);
+
+    /// true if sample events of the raw file agree with their entries
+    bool Matches(const std::string &raw_path, uint64_t raw_size) const;
+
+    void Add(const Entry &e) {m_entries.push_back(e);};
+    void Save(const std::string &idx_path, bool overwrite = true) const;
+    size_t Size() const {return m_entries.size();};
+    const Entry &At(size_t i) const {return m_entries.at(i);};
+    /// positions of the events passing the same cuts as euCliReader,
+    /// a range where both limits are zero is not applied
+    std::vector<uint32_t> Select(uint32_t evl, uint32_t evh,
+                                 uint32_t tgl, uint32_t tgh,
+                                 uint64_t tsl, uint64_t tsh) const;
+
+  private:
+    std::vector<Entry> m_entries;
+  };
+
+  /// Appends index entries while the raw file is being written
+  class DLLEXPORT EventIndexWriter {
+  public:
+    EventIndexWriter(const std::string &idx_path, bool overwrite = false);
+    void Write(const EventIndex::Entry &e);
+    void Flush() {m_ser.Flush();};
+  private:
+    FileSerializer m_ser;
+  };
+}
+
+#endif // EUDAQ_INCLUDED_EventIndex
@@ -17,10 +17,13 @@ namespace eudaq{
     ~FileDeserializer();
     virtual bool HasData();
     bool ReadEvent(int ver, EventSP &ev, size_t skip = 0);
+    uint64_t Tell() const { return m_file_pos - level(); }
+    void Seek(uint64_t pos);
     
   private:
     virtual void Deserialize(uint8_t *data, size_t len);
     virtual void PreDeserialize(uint8_t *data, size_t len);
+    virtual DataBlock DeserializeBlock(size_t len);
     size_t FillBuffer(size_t min = 0);
     size_t level() const { return m_stop - m_start; }
     FILE *m_file;
@@ -28,6 +31,11 @@ namespace eudaq{
     std::vector<uint8_t> m_buf;
     uint8_t *m_start;
     uint8_t *m_stop;
+    uint64_t m_file_pos; // bytes read from the file so far
+    // blocks are carved out of a shared arena instead of being allocated one by one
+    std::shared_ptr<uint8_t> m_arena;
+    size_t m_arena_size;
+    size_t m_arena_offset;
   };
 }
 #endif // EUDAQ_INCLUDED_FileSerializer
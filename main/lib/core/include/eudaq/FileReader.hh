@@ -6,6 +6,7 @@
 #include "eudaq/Configuration.hh"
 #include "eudaq/Factory.hh"
 #include "eudaq/Event.hh"
+#include "eudaq/EventIndex.hh"
 
 
 namespace eudaq{
@@ -30,6 +31,11 @@ namespace eudaq{
     void SetConfiguration(ConfigurationSPC c) {m_conf = c;};
     ConfigurationSPC GetConfiguration() const {return m_conf;};
     virtual EventSPC GetNextEvent() {return nullptr;};
+    /// position the reader so that GetNextEvent returns the i-th event of the file
+    virtual bool Seek(uint32_t i) {return false;};
+    virtual EventSPC GetEvent(uint32_t i);
+    /// sidecar index of the file, nullptr if there is none
+    virtual EventIndexSPC GetIndex() const {return nullptr;};
     static FileReaderSP Make(std::string type, std::string path);
   private:
     ConfigurationSPC m_conf;
@@ -34,7 +34,16 @@ namespace eudaq {
     void SetConfiguration(ConfigurationSPC c) {m_conf = c;};
     ConfigurationSPC GetConfiguration() const {return m_conf;};
     virtual void WriteEvent(EventSPC ) {};
+    /// Writes several events in a row, by default one after the other
+    virtual void WriteEvents(const std::vector<EventSPC> &evs) {for(auto &ev: evs) WriteEvent(ev);};
+    /// The conversion part of WriteEvent, which must not touch the output.
+    /// It may run concurrently for different events, and its result is
+    /// given to WriteConverted in the original order of the events.
+    virtual std::shared_ptr<void> ConvertEvent(EventSPC ) const {return nullptr;};
+    virtual void WriteConverted(EventSPC ev, std::shared_ptr<void> ) {WriteEvent(ev);};
     virtual uint64_t FileBytes() const {return 0;};
+    /// Path of the file being written, empty if none
+    virtual std::string FileName() const {return "";};
     static FileWriterSP Make(std::string type, std::string path);
   private:
     ConfigurationSPC m_conf;
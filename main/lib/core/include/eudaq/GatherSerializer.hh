@@ -0,0 +1,39 @@
+#ifndef EUDAQ_INCLUDED_GatherSerializer
+#define EUDAQ_INCLUDED_GatherSerializer
+
+#include "eudaq/Serializer.hh"
+#include "eudaq/DataBlock.hh"
+#include "eudaq/Platform.hh"
+
+#include <vector>
+
+namespace eudaq {
+  /** Serializer for scatter-gather output.
+   * Small items are copied into an internal buffer, while data blocks of at
+   * least min_ref bytes are only referenced. Parts() returns the pieces in
+   * order; the referenced blocks must stay alive until they are sent.
+   */
+  class DLLEXPORT GatherSerializer : public Serializer {
+  public:
+    GatherSerializer(size_t min_ref = 1024);
+    std::vector<BlockView> Parts() const;
+    size_t size() const { return m_buf.size() + m_ref_size; }
+    void clear();
+
+  private:
+    void Serialize(const uint8_t *data, size_t len) override;
+    void SerializeBlock(const uint8_t *data, size_t len) override;
+    struct Part {
+      const uint8_t *ptr; // referenced block, or nullptr for the buffer
+      size_t offset; // position in the buffer
+      size_t len;
+    };
+    size_t m_min_ref;
+    std::vector<uint8_t> m_buf;
+    std::vector<Part> m_parts;
+    size_t m_start; // begin of the buffered data not yet in m_parts
+    size_t m_ref_size;
+  };
+}
+
+#endif // EUDAQ_INCLUDED_GatherSerializer
@@ -0,0 +1,340 @@
+#ifndef EUDAQ_INCLUDED_LockFreeQueue
+#define EUDAQ_INCLUDED_LockFreeQueue
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <thread>
+#include <cstdint>
+#include <cstddef>
+
+namespace eudaq {
+
+  struct QueueStats {
+    uint64_t pushed; // items accepted, including spilled ones
+    uint64_t popped;
+    uint64_t full; // pushes that found the ring full
+    uint64_t spilled; // items that went to the overflow list
+    uint64_t max_depth; // highest number of queued items seen
+  };
+
+  /** Bounded multi-producer multi-consumer ring queue.
+   * Push and pop are lock-free (one CAS each). Blocking calls only sleep when
+   * the ring is empty or full, and the other side only touches the mutex and
+   * condition variable when somebody is actually asleep.
+   * PushOrSpill never blocks: when the ring is full, items go to a locked
+   * overflow list that is drained once the ring is empty, so the order of
+   * the items of each producer is kept.
+   */
+  template <typename T> class LockFreeQueue {
+  public:
+    explicit LockFreeQueue(size_t capacity)
+      : m_enq(0), m_deq(0), m_closed(false), m_wait_pop(0), m_wait_push(0),
+        m_sig_pop(false), m_sig_push(false),
+        m_full(0), m_spilled(0), m_spill_n(0), m_max_depth(0) {
+      size_t n = 2;
+      while (n < capacity)
+        n <<= 1;
+      m_mask = n - 1;
+      m_cells.reset(new Cell[n]);
+      for (size_t i = 0; i < n; i++)
+        m_cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+    LockFreeQueue(const LockFreeQueue &) = delete;
+    LockFreeQueue &operator=(const LockFreeQueue &) = delete;
+
+    bool TryPush(T &&v) {
+      if (!Enqueue(v))
+        return false;
+      WakePop(false);
+      return true;
+    }
+    bool TryPush(const T &v) {
+      T t(v);
+      return TryPush(std::move(t));
+    }
+
+    /// Waits up to timeout for free space, false if full or closed
+    template <typename DUR> bool Push(T &&v, DUR timeout) {
+      if (m_closed.load(std::memory_order_acquire))
+        return false;
+      if (TryPush(std::move(v)))
+        return true;
+      m_full.fetch_add(1, std::memory_order_relaxed);
+      auto deadline = std::chrono::steady_clock::now() + timeout;
+      m_wait_push.fetch_add(1);
+      std::unique_lock<std::mutex> lk(m_mtx);
+      bool ok = false;
+      for (;;) {
+        m_sig_push.store(false);
+        if ((ok = Enqueue(v)) || m_closed.load(std::memory_order_acquire))
+          break;
+        if (m_cv_space.wait_until(lk, deadline) == std::cv_status::timeout) {
+          ok = Enqueue(v);
+          break;
+        }
+      }
+      lk.unlock();
+      m_wait_push.fetch_sub(1);
+      if (ok)
+        WakePop(false);
+      return ok;
+    }
+    /// Waits for free space as long as the queue is open
+    bool Push(T &&v) {
+      while (!m_closed.load(std::memory_order_acquire))
+        if (Push(std::move(v), std::chrono::seconds(1)))
+          return true;
+      return false;
+    }
+
+    /// Never blocks, a full ring overflows into an unbounded list
+    bool PushOrSpill(T &&v) {
+      if (m_closed.load(std::memory_order_acquire))
+        return false;
+      if (m_spill_n.load(std::memory_order_acquire) == 0 && Enqueue(v)) {
+        WakePop(false);
+        return true;
+      }
+      {
+        std::lock_guard<std::mutex> lk(m_mtx_spill);
+        if (m_spill.empty())
+          m_full.fetch_add(1, std::memory_order_relaxed);
+        m_spill.push_back(std::move(v));
+        m_spill_n.fetch_add(1, std::memory_order_release);
+        m_spilled.fetch_add(1, std::memory_order_relaxed);
+        UpdateDepth(Size());
+      }
+      WakePop(false);
+      return true;
+    }
+
+    bool TryPop(T &v) {
+      if (Dequeue(v) || Unspill(v)) {
+        WakePush(false);
+        return true;
+      }
+      return false;
+    }
+
+    /// Waits up to timeout for an item, false on timeout or if closed and
+    /// drained
+    template <typename DUR> bool Pop(T &v, DUR timeout) {
+      // a short spin catches items that are just being pushed, without a
+      // sleep and wake-up; pointless on a single core
+      static const int spin = std::thread::hardware_concurrency() > 1 ? 256 : 1;
+      for (int i = 0; i < spin; i++) {
+        if (TryPop(v))
+          return true;
+        if (m_closed.load(std::memory_order_acquire))
+          return false;
+      }
+      auto deadline = std::chrono::steady_clock::now() + timeout;
+      m_wait_pop.fetch_add(1);
+      std::unique_lock<std::mutex> lk(m_mtx);
+      bool ok = false;
+      for (;;) {
+        m_sig_pop.store(false);
+        if ((ok = (Dequeue(v) || Unspill(v))) ||
+            m_closed.load(std::memory_order_acquire))
+          break;
+        if (m_cv_data.wait_until(lk, deadline) == std::cv_status::timeout) {
+          ok = Dequeue(v) || Unspill(v);
+          break;
+        }
+      }
+      lk.unlock();
+      m_wait_pop.fetch_sub(1);
+      if (ok)
+        WakePush(false);
+      return ok;
+    }
+
+    /// Moves up to max queued items to the end of out without blocking
+    size_t PopBatch(std::vector<T> &out, size_t max) {
+      size_t n = 0;
+      T v;
+      while (n < max && (Dequeue(v) || Unspill(v))) {
+        out.push_back(std::move(v));
+        n++;
+      }
+      if (n)
+        WakePush(true);
+      return n;
+    }
+
+    /// Wakes all waiting threads; pushes fail and pops drain what is left
+    void Close() {
+      m_closed.store(true, std::memory_order_release);
+      std::lock_guard<std::mutex> lk(m_mtx);
+      m_cv_data.notify_all();
+      m_cv_space.notify_all();
+    }
+    void Open() { m_closed.store(false, std::memory_order_release); }
+    bool IsClosed() const { return m_closed.load(std::memory_order_acquire); }
+
+    void Clear() {
+      T v;
+      while (Dequeue(v) || Unspill(v)) {
+      }
+      WakePush(true);
+    }
+
+    size_t Size() const {
+      size_t deq = m_deq.load(std::memory_order_acquire);
+      size_t enq = m_enq.load(std::memory_order_acquire);
+      return (enq > deq ? enq - deq : 0) +
+             m_spill_n.load(std::memory_order_acquire);
+    }
+    bool Empty() const { return Size() == 0; }
+    size_t Capacity() const { return m_mask + 1; }
+
+    QueueStats GetStats() const {
+      QueueStats s;
+      s.spilled = m_spilled.load(std::memory_order_relaxed);
+      s.popped = m_deq.load(std::memory_order_relaxed) + s.spilled -
+                 m_spill_n.load(std::memory_order_relaxed);
+      s.pushed = m_enq.load(std::memory_order_relaxed) + s.spilled;
+      s.full = m_full.load(std::memory_order_relaxed);
+      s.max_depth = m_max_depth.load(std::memory_order_relaxed);
+      return s;
+    }
+
+  private:
+    struct Cell {
+      std::atomic<size_t> seq;
+      T data;
+    };
+
+    // moves from v only on success
+    bool Enqueue(T &v) {
+      Cell *c;
+      size_t pos = m_enq.load(std::memory_order_relaxed);
+      for (;;) {
+        c = &m_cells[pos & m_mask];
+        size_t seq = c->seq.load(std::memory_order_acquire);
+        intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (dif == 0) {
+          if (m_enq.compare_exchange_weak(pos, pos + 1,
+                                          std::memory_order_relaxed))
+            break;
+        } else if (dif < 0)
+          return false;
+        else
+          pos = m_enq.load(std::memory_order_relaxed);
+      }
+      c->data = std::move(v);
+      c->seq.store(pos + 1, std::memory_order_release);
+      size_t deq = m_deq.load(std::memory_order_relaxed);
+      if (pos + 1 > deq)
+        UpdateDepth(pos + 1 - deq);
+      return true;
+    }
+
+    bool Dequeue(T &v) {
+      Cell *c;
+      size_t pos = m_deq.load(std::memory_order_relaxed);
+      for (;;) {
+        c = &m_cells[pos & m_mask];
+        size_t seq = c->seq.load(std::memory_order_acquire);
+        intptr_t dif =
+            static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+        if (dif == 0) {
+          if (m_deq.compare_exchange_weak(pos, pos + 1,
+                                          std::memory_order_relaxed))
+            break;
+        } else if (dif < 0)
+          return false;
+        else
+          pos = m_deq.load(std::memory_order_relaxed);
+      }
+      v = std::move(c->data);
+      c->data = T(); // do not keep the item alive in the ring
+      c->seq.store(pos + m_mask + 1, std::memory_order_release);
+      return true;
+    }
+
+    // the overflow list is only taken from once the ring is empty; a cell
+    // claimed but not yet published may hold an item older than the spilled
+    // ones of its producer, so a failed Dequeue is not enough
+    bool Unspill(T &v) {
+      if (m_spill_n.load(std::memory_order_acquire) == 0)
+        return false;
+      if (m_enq.load(std::memory_order_acquire) !=
+          m_deq.load(std::memory_order_acquire))
+        return false;
+      std::lock_guard<std::mutex> lk(m_mtx_spill);
+      if (m_spill.empty())
+        return false;
+      v = std::move(m_spill.front());
+      m_spill.pop_front();
+      m_spill_n.fetch_sub(1, std::memory_order_release);
+      return true;
+    }
+
+    void UpdateDepth(size_t depth) {
+      uint64_t max = m_max_depth.load(std::memory_order_relaxed);
+      while (depth > max &&
+             !m_max_depth.compare_exchange_weak(max, depth,
+                                                std::memory_order_relaxed)) {
+      }
+    }
+
+    // The fence orders the publication of an item (or of free space) before
+    // the check for sleepers, which pairs with the waiter resetting its
+    // signal flag before it looks at the ring. A single sleeper is signalled
+    // only once, and producers only when half of the ring is free again, so
+    // a sleeping thread does not cost the other side a syscall per item.
+    // With several sleepers the flag may still be set by a wake-up that went
+    // to another one, so all of them are woken and look at the ring again.
+    void WakePop(bool all) {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      uint32_t waiting = m_wait_pop.load(std::memory_order_relaxed);
+      if (!waiting)
+        return;
+      if (!m_sig_pop.exchange(true) || waiting > 1) {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        all || waiting > 1 ? m_cv_data.notify_all() : m_cv_data.notify_one();
+      }
+    }
+    void WakePush(bool all) {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      uint32_t waiting = m_wait_push.load(std::memory_order_relaxed);
+      if (!waiting || Size() > Capacity() / 2)
+        return;
+      if (!m_sig_push.exchange(true) || waiting > 1) {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        all || waiting > 1 ? m_cv_space.notify_all() : m_cv_space.notify_one();
+      }
+    }
+
+    std::unique_ptr<Cell[]> m_cells;
+    size_t m_mask;
+    // keep the producer and consumer positions on separate cache lines
+    char m_pad0[64];
+    std::atomic<size_t> m_enq;
+    char m_pad1[64];
+    std::atomic<size_t> m_deq;
+    char m_pad2[64];
+    std::atomic<bool> m_closed;
+    std::atomic<uint32_t> m_wait_pop;
+    std::atomic<uint32_t> m_wait_push;
+    std::atomic<bool> m_sig_pop;
+    std::atomic<bool> m_sig_push;
+    std::atomic<uint64_t> m_full;
+    std::atomic<uint64_t> m_spilled;
+    std::atomic<size_t> m_spill_n;
+    std::atomic<uint64_t> m_max_depth;
+    std::mutex m_mtx;
+    std::condition_variable m_cv_data;
+    std::condition_variable m_cv_space;
+    std::mutex m_mtx_spill;
+    std::deque<T> m_spill;
+  };
+}
+
+#endif // EUDAQ_INCLUDED_LockFreeQueue
@@ -0,0 +1,39 @@
+#ifndef EUDAQ_INCLUDED_MappedFileDeserializer
+#define EUDAQ_INCLUDED_MappedFileDeserializer
+
+#include "eudaq/Deserializer.hh"
+#include "eudaq/DataBlock.hh"
+#include "eudaq/Exception.hh"
+#include "eudaq/Platform.hh"
+#include <memory>
+#include <string>
+
+namespace eudaq {
+  /** Deserializer reading from a read-only memory mapping of a whole file.
+   * Data blocks are not copied, they refer directly to the mapping, which
+   * stays alive as long as any of them is in use.
+   */
+  class DLLEXPORT MappedFileDeserializer : public Deserializer {
+  public:
+    MappedFileDeserializer(const std::string &fname);
+    ~MappedFileDeserializer() override;
+    bool HasData() override;
+    uint64_t Tell() const { return m_rd_pos; }
+    uint64_t Size() const { return m_size; }
+    void Seek(uint64_t pos);
+    /// the mapping is read ahead as long as the file is read in order,
+    /// random access to events should switch this off
+    void SetSequential(bool seq);
+
+  private:
+    void Deserialize(uint8_t *data, size_t len) override;
+    void PreDeserialize(uint8_t *data, size_t len) override;
+    DataBlock DeserializeBlock(size_t len) override;
+    void CheckAvailable(size_t len) const;
+    std::shared_ptr<const uint8_t> m_map;
+    uint64_t m_size;
+    bool m_sequential;
+  };
+}
+
+#endif // EUDAQ_INCLUDED_MappedFileDeserializer
@@ -26,6 +26,15 @@ using std::size_t;
 
 #define EUDAQ_PLATFORM_IS(P) (EUDAQ_PLATFORM == PF_##P)
 
+// the serialized format of EUDAQ is little-endian, on such hosts the
+// in-memory representation of arithmetic types can be copied as it is
+#if defined(_WIN32) ||                                                         \
+    (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define EUDAQ_LITTLE_ENDIAN 1
+#else
+#define EUDAQ_LITTLE_ENDIAN 0
+#endif
+
 #if EUDAQ_PLATFORM_IS(WIN32)
 
 #ifdef EUDAQ_CORE_EXPORTS
@@ -4,7 +4,7 @@
 #include <set>
 #include <vector>
 #include <string>
-#include <queue>
+#include <deque>
 #include <memory>
 #include <thread>
 #include <mutex>
@@ -13,6 +13,8 @@
 
 #include "Event.hh"
 #include "Factory.hh"
+#include "LockFreeQueue.hh"
+#include "TaskExecutor.hh"
 
 namespace eudaq {
   class Processor;
@@ -28,6 +30,18 @@ namespace eudaq {
   using ProcessorSP = Factory<Processor>::SP_BASE;
   using ProcessorWP = Factory<Processor>::WP_BASE;
   
+  /** Node of a processing graph. The nodes have no threads of their own:
+   * an event registered to a node is queued and the node runs as a task of
+   * the shared TaskExecutor. An ordered node handles one event after the
+   * other in arrival order. A stateless node may handle several events at
+   * once; what it forwards is held back until the events before are done,
+   * so every edge of the graph delivers its events in order either way.
+   * Only ProduceEvent, started by SYS:PD:RUN, has a thread.
+   * ProcessEvent holds a thread of the shared pool and must not block, e.g.
+   * on file or socket I/O, or the other nodes stall with it. A node which
+   * does gets a thread of its own with SYS:CS:RUN, SYS:CS:STOP finishes its
+   * queued work and returns it to the pool.
+   */
   class DLLEXPORT Processor: public std::enable_shared_from_this<Processor>{
   public:
     static ProcessorSP MakeShared(const std::string& pstype,
@@ -39,12 +53,20 @@ namespace eudaq {
     Processor() = delete;
     virtual ~Processor();
     virtual void ProcessEvent(EventSPC ev);
+    /// A batch of events in order, by default given to ProcessEvent one by one
+    virtual void ProcessEvents(const std::vector<EventSPC> &evs);
     virtual void ProduceEvent(){};
     virtual void ProcessCommand(const std::string& cmd, const std::string& arg){};
 
     void ForwardEvent(EventSPC ev);
     void RegisterEvent(EventSPC ev);
+    /// batch variants, each takes its locks and schedules once per batch
+    void ForwardEvents(const std::vector<EventSPC> &evs);
+    void RegisterEvents(const std::vector<EventSPC> &evs);
 
+    /// set before events arrive, also by SYS:PS:STATELESS=1
+    void SetStateless(bool stateless) {m_stateless = stateless;};
+    inline bool IsStateless() const {return m_stateless;};
     void StopProducer();
     inline bool GetProducerStopFlag() const {return m_pdc_go_stop;};
     inline uint32_t GetInstanceN()const {return m_instance_n;};
@@ -59,38 +81,35 @@ namespace eudaq {
     ProcessorSP operator<<=(EventSPC ev);
 
   private:
-    void Processing(EventSPC ev);
-    void ConsumeEvent();
-    void HubProcessing(); //relay
+    struct Slot {
+      std::vector<EventSPC> out; // forwarded while processing the event
+      bool done;
+    };
+    void RunOrdered();
+    void RunStateless(const std::vector<EventSPC> &evs, Slot *slot);
+    void Schedule(TaskExecutor::Task t);
     void ProcessSysCommand(const std::string& cmd, const std::string& arg);
-    void RegisterProcessing(ProcessorSP ps, EventSPC ev);
     void RegisterDownstream(ProcessorSP ps, const std::set<uint32_t>& evset = {});
-    void RegisterUpstream(ProcessorSP up, ProcessorWP hub);
+    void RegisterUpstream(ProcessorSP up);
     
   private:
     std::string m_description;
     uint32_t m_instance_n;
     
-    ProcessorWP m_ps_hub;
     std::vector<ProcessorWP> m_ps_upstream;
     std::vector<std::pair<ProcessorSP, std::set<uint32_t>>> m_ps_downstream;
-    std::mutex m_mtx_input;  // m_ps_upstream, m_ps_hub; guard the event intput
+    std::mutex m_mtx_input;  // m_ps_upstream; guard the event intput
     std::mutex m_mtx_output; // m_ps_downstream; guard the event output
     // std::mutex m_mtx_config;
     
-    std::atomic_bool m_hub_force;
-    
-    std::deque<EventSPC> m_que_csm;
-    std::deque<std::pair<ProcessorSP, EventSPC> > m_que_hub;
-    std::mutex m_mtx_csm;
-    std::mutex m_mtx_hub;
-    std::condition_variable m_cv_csm;
-    std::condition_variable m_cv_hub;
-    std::thread m_th_csm;
-    std::thread m_th_hub;
+    std::atomic_bool m_stateless;
+    LockFreeQueue<EventSPC> m_que_in; // of an ordered node
+    std::atomic_bool m_scheduled;
+    std::mutex m_mtx_slot; // m_slots, release of the output of a stateless node
+    std::deque<Slot> m_slots; // events of a stateless node in arrival order
+    std::mutex m_mtx_exec; // m_exec
+    std::unique_ptr<TaskExecutor> m_exec; // own thread, see SYS:CS:RUN
     std::thread m_th_pdc;
-    std::atomic_bool m_csm_go_stop;
-    std::atomic_bool m_hub_go_stop;
     std::atomic_bool m_pdc_go_stop;
     
     std::set<uint32_t> m_ev_out_default;
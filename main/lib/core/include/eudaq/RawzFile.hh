@@ -0,0 +1,47 @@
+#ifndef EUDAQ_INCLUDED_RawzFile
+#define EUDAQ_INCLUDED_RawzFile
+
+#include "eudaq/Platform.hh"
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace eudaq {
+  /** Layout of the compressed native format (.rawz).
+   *
+   * header : magic, version, codec                       (3 x uint32)
+   * chunk  : raw size, compressed size, number of events (3 x uint32)
+   *          followed by the compressed bytes of the serialized events
+   * ...
+   * index  : number of chunks (uint32), then per chunk its file offset
+   *          and the file position of its first event (2 x uint64)
+   * trailer: file offset of the index (uint64), magic (uint32)
+   *
+   * Every chunk is compressed independently, so it can be decoded on its
+   * own. A file without trailer (e.g. from a crashed run) is still readable
+   * by walking the chunk headers.
+   */
+  namespace rawz {
+    const uint32_t FILE_MAGIC = 0x5a574152; // "RAWZ"
+    const uint32_t INDEX_MAGIC = 0x58444e49; // "INDX"
+    const uint32_t VERSION = 1;
+    const uint32_t CODEC_ZLIB = 1;
+    const size_t HEADER_SIZE = 12;
+    const size_t CHUNK_HEADER_SIZE = 12;
+    const size_t TRAILER_SIZE = 12;
+
+    struct ChunkInfo {
+      uint64_t offset; // file offset of the chunk header
+      uint64_t first_event; // position of its first event in the file
+    };
+
+    DLLEXPORT bool Available();
+    DLLEXPORT std::vector<uint8_t> Compress(const uint8_t *data, size_t len,
+                                            int level);
+    DLLEXPORT void Decompress(const uint8_t *data, size_t len,
+                              uint8_t *out, size_t out_len);
+  }
+}
+
+#endif // EUDAQ_INCLUDED_RawzFile
@@ -1,10 +1,20 @@
 #ifndef EUDAQ_INCLUDED_Serializable
 #define EUDAQ_INCLUDED_Serializable
 #include "eudaq/Platform.hh"
+#include <type_traits>
 namespace eudaq {
 
   class Serializer;
 
+  /** True for types whose in-memory representation is identical to their
+   * serialized form, so that arrays of them can be copied in one go.
+   */
+  template <typename T>
+  struct is_bulk_serializable
+    : std::integral_constant<bool, EUDAQ_LITTLE_ENDIAN &&
+                                       std::is_arithmetic<T>::value &&
+                                       !std::is_same<T, bool>::value> {};
+
   class DLLEXPORT Serializable {
   public:
     virtual void Serialize(Serializer &) const = 0;
@@ -10,6 +10,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <cstring>
 
 namespace eudaq {
 
@@ -19,6 +20,7 @@ namespace eudaq {
 
   class DLLEXPORT Serializer {
   public:
+    Serializer() : m_wr_buf(nullptr) {}
     virtual ~Serializer();
     virtual void Flush();
     void write(const Serializable &t);
@@ -28,12 +30,34 @@ namespace eudaq {
     template <typename T, typename U> void write(const std::pair<T, U> &t);
 
     void append(const uint8_t *data, size_t size);
+    /// Appends a payload that stays valid and unchanged until the serialized
+    /// data is consumed (e.g. a DataBlock), so it may be referenced, not copied
+    void append_block(const uint8_t *data, size_t size) {
+      SerializeBlock(data, size);
+    }
     virtual uint64_t GetCheckSum();
+  protected:
+    /// if set, append() writes into this buffer without the virtual call
+    std::vector<uint8_t> *m_wr_buf;
   private:
     template <typename T> friend struct WriteHelper;
     virtual void Serialize(const uint8_t *, size_t) = 0;
+    virtual void SerializeBlock(const uint8_t *data, size_t size) {
+      append(data, size);
+    }
+    template <typename T>
+    void write_elements(const std::vector<T> &t, std::true_type);
+    template <typename T>
+    void write_elements(const std::vector<T> &t, std::false_type);
   };
 
+  inline void Serializer::append(const uint8_t *data, size_t size) {
+    if (m_wr_buf)
+      m_wr_buf->insert(m_wr_buf->end(), data, data + size);
+    else
+      Serialize(data, size);
+  }
+
   template <typename T> struct WriteHelper {
     typedef void (*writer)(Serializer &ser, const T &v);
     static writer GetFunc(Serializable *) { return write_ser; }
@@ -56,37 +80,49 @@ namespace eudaq {
                                     "byte!");
       uint8_t buf[sizeof(char)];
       buf[0] = static_cast<uint8_t>(v & 0xff);
-      sr.Serialize(buf, sizeof(char));
+      sr.append(buf, sizeof(char));
     }
 
     static void write_int(Serializer &sr, const T &v) {
       static_assert(sizeof(v) > 1, "Called write_int() in Serializer.hh which "
                                    "only supports integers of size > 1 byte!");
+#if EUDAQ_LITTLE_ENDIAN
+      sr.append(reinterpret_cast<const uint8_t *>(&v), sizeof v);
+#else
       T t = v;
       uint8_t buf[sizeof v];
       for (size_t i = 0; i < sizeof v; ++i) {
         buf[i] = static_cast<uint8_t>(t & 0xff);
         t >>= 8;
       }
-      sr.Serialize(buf, sizeof v);
+      sr.append(buf, sizeof v);
+#endif
     }
     static void write_float(Serializer &sr, const float &v) {
+#if EUDAQ_LITTLE_ENDIAN
+      sr.append(reinterpret_cast<const uint8_t *>(&v), sizeof v);
+#else
       unsigned t = *(unsigned *)&v;
       uint8_t buf[sizeof t];
       for (size_t i = 0; i < sizeof t; ++i) {
         buf[i] = t & 0xff;
         t >>= 8;
       }
-      sr.Serialize(buf, sizeof t);
+      sr.append(buf, sizeof t);
+#endif
     }
     static void write_double(Serializer &sr, const double &v) {
+#if EUDAQ_LITTLE_ENDIAN
+      sr.append(reinterpret_cast<const uint8_t *>(&v), sizeof v);
+#else
       uint64_t t = *(uint64_t *)&v;
       uint8_t buf[sizeof t];
       for (size_t i = 0; i < sizeof t; ++i) {
         buf[i] = t & 0xff;
         t >>= 8;
       }
-      sr.Serialize(buf, sizeof t);
+      sr.append(buf, sizeof t);
+#endif
     }
   };
 
@@ -96,7 +132,7 @@ namespace eudaq {
 
   template <> inline void Serializer::write(const std::string &t) {
     write((unsigned)t.length());
-    Serialize(reinterpret_cast<const uint8_t *>(&t[0]), t.length());
+    append(reinterpret_cast<const uint8_t *>(t.data()), t.length());
   }
 
   template <> inline void Serializer::write(const Time &t) {
@@ -115,7 +151,19 @@ namespace eudaq {
   template <typename T> inline void Serializer::write(const std::vector<T> &t) {
     unsigned len = t.size();
     write(len);
-    for (size_t i = 0; i < len; ++i) {
+    write_elements(t, is_bulk_serializable<T>());
+  }
+
+  template <typename T>
+  inline void Serializer::write_elements(const std::vector<T> &t,
+                                         std::true_type) {
+    append(reinterpret_cast<const uint8_t *>(t.data()), t.size() * sizeof(T));
+  }
+
+  template <typename T>
+  inline void Serializer::write_elements(const std::vector<T> &t,
+                                         std::false_type) {
+    for (size_t i = 0; i < t.size(); ++i) {
       write(t[i]);
     }
   }
@@ -124,12 +172,12 @@ namespace eudaq {
   inline void
   Serializer::write<uint8_t>(const std::vector<uint8_t> &t) {
     write((unsigned)t.size());
-    Serialize(&t[0], t.size());
+    append(t.data(), t.size());
   }
 
   template <> inline void Serializer::write<char>(const std::vector<char> &t) {
     write((unsigned)t.size());
-    Serialize(reinterpret_cast<const uint8_t *>(&t[0]), t.size());
+    append(reinterpret_cast<const uint8_t *>(t.data()), t.size());
   }
 
   template <typename T, typename U>
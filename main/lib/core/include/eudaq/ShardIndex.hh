@@ -0,0 +1,45 @@
+#ifndef EUDAQ_INCLUDED_ShardIndex
+#define EUDAQ_INCLUDED_ShardIndex
+
+#include "eudaq/Platform.hh"
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+
+namespace eudaq {
+  class ShardIndex;
+  using ShardIndexSP = std::shared_ptr<ShardIndex>;
+
+  /** Index of a run which was written to several shard files in parallel,
+   * stored as <pattern>.shards next to them. It lists the shard files and,
+   * for every event in the original order, the shard which holds it, so
+   * that a reader can stitch the shards back together.
+   */
+  class DLLEXPORT ShardIndex {
+  public:
+    static const uint32_t MAX_SHARDS = 256;
+
+    ShardIndex(const std::string &type = "native") :m_type(type) {};
+    static ShardIndexSP Load(const std::string &path);
+    void Save(const std::string &path) const;
+
+    /// FileReader type of the shards
+    std::string GetType() const {return m_type;};
+    void SetShardN(uint32_t n);
+    uint32_t GetShardN() const {return m_paths.size();};
+    void SetPath(uint32_t shard, const std::string &path);
+    std::string GetPath(uint32_t shard) const {return m_paths.at(shard);};
+    void Add(uint32_t shard) {m_seq.push_back(static_cast<uint8_t>(shard));};
+    size_t Size() const {return m_seq.size();};
+    uint32_t At(size_t i) const {return m_seq.at(i);};
+
+  private:
+    std::string m_type;
+    std::vector<std::string> m_paths;
+    std::vector<uint8_t> m_seq;
+  };
+}
+
+#endif // EUDAQ_INCLUDED_ShardIndex
@@ -23,9 +23,14 @@ namespace eudaq {
     StandardEvent(Deserializer &);
 
     StandardPlane &AddPlane(const StandardPlane &);
+    StandardPlane &AddPlane(StandardPlane &&);
     size_t NumPlanes() const;
     const StandardPlane &GetPlane(size_t i) const;
     StandardPlane &GetPlane(size_t i);
+    /// Serializes the planes as CompactPlanes where they fit; readers
+    /// older than the compact form can not read such events
+    void SetFlagCompact();
+    bool IsFlagCompact() const;
     virtual void Serialize(Serializer &) const;
     virtual void Print(std::ostream & os,size_t offset = 0) const;
     
@@ -12,7 +12,10 @@
 
 namespace eudaq {
 
+  class CompactPlane;
+
   class DLLEXPORT StandardPlane : public Serializable {
+    friend class CompactPlane;
   public:
     enum FLAGS {
       FLAG_ZS = 0x1, // Data are zero suppressed
@@ -21,7 +24,8 @@ namespace eudaq {
       FLAG_ACCUMULATE = 0x8, // Multiple frames should be accumulated for output
       FLAG_WITHPIVOT = 0x10000, // Include before/after pivot boolean per pixel
       FLAG_WITHSUBMAT = 0x20000, // Include Submatrix ID per pixel
-      FLAG_DIFFCOORDS = 0x40000 // Each frame can have different coordinates (in ZS mode)
+      FLAG_DIFFCOORDS = 0x40000, // Each frame can have different coordinates (in ZS mode)
+      FLAG_WITHTIME = 0x80000 // Include a 64 bit timestamp per pixel (in ZS mode)
     };
     typedef double pixel_t;
     typedef double coord_t;
@@ -30,6 +34,8 @@ namespace eudaq {
     StandardPlane(Deserializer &);
     StandardPlane();
     void Serialize(Serializer &) const;
+    /// Writes the plane as a CompactPlane if it fits, else as Serialize does
+    void SerializeCompact(Serializer &) const;
     void SetSizeRaw(uint32_t w, uint32_t h, uint32_t frames = 1, int flags = 0);
     void SetSizeZS(uint32_t w, uint32_t h, uint32_t npix, uint32_t frames = 1,
                    int flags = 0);
@@ -58,6 +64,9 @@ namespace eudaq {
                         bool pivot, uint32_t frame);
     void PushPixelHelper(uint32_t x, uint32_t y, double pix, bool pivot,
                          uint32_t frame);
+    /// appends n hits of value 1 to frame, pivot may be nullptr
+    void PushPixels(uint32_t frame, const uint16_t *x, const uint16_t *y,
+                    uint32_t n, const uint8_t *pivot = nullptr);
     double GetPixel(uint32_t index, uint32_t frame) const;
     double GetPixel(uint32_t index) const;
     double GetX(uint32_t index, uint32_t frame) const;
@@ -66,6 +75,9 @@ namespace eudaq {
     double GetY(uint32_t index) const;
     bool GetPivot(uint32_t index, uint32_t frame = 0) const;
     void SetPivot(uint32_t index, uint32_t frame, bool PivotFlag);
+    /// the timestamp of a pixel, 0 without FLAG_WITHTIME
+    uint64_t GetTime(uint32_t index, uint32_t frame = 0) const;
+    void SetTime(uint32_t index, uint64_t time, uint32_t frame = 0);
     // defined for short, int, double
     template <typename T> std::vector<T> GetPixels() const {
       SetupResult();
@@ -119,6 +131,7 @@ namespace eudaq {
     std::vector<std::vector<pixel_t>> m_pix;
     std::vector<std::vector<coord_t>> m_x, m_y;
     std::vector<std::vector<bool>> m_pivot;
+    std::vector<std::vector<uint64_t>> m_time;
     std::vector<uint32_t> m_mat;
 
     mutable const std::vector<pixel_t> *m_result_pix;
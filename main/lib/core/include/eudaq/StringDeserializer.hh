@@ -0,0 +1,30 @@
+#ifndef EUDAQ_INCLUDED_StringDeserializer
+#define EUDAQ_INCLUDED_StringDeserializer
+
+#include "eudaq/Deserializer.hh"
+#include "eudaq/DataBlock.hh"
+#include "eudaq/Platform.hh"
+#include <memory>
+#include <string>
+
+namespace eudaq {
+  /** Deserializer taking over a received packet.
+   * Data blocks are not copied, they refer directly to the packet, which
+   * stays alive as long as any of them is in use.
+   */
+  class DLLEXPORT StringDeserializer : public Deserializer {
+  public:
+    StringDeserializer(std::string &&data);
+    bool HasData() override { return m_rd_pos < m_data->size(); }
+
+  private:
+    void Deserialize(uint8_t *data, size_t len) override;
+    void PreDeserialize(uint8_t *data, size_t len) override;
+    DataBlock DeserializeBlock(size_t len) override;
+    void CheckAvailable(size_t len) const;
+    const uint8_t *At() const;
+    std::shared_ptr<const std::string> m_data;
+  };
+}
+
+#endif // EUDAQ_INCLUDED_StringDeserializer
@@ -0,0 +1,63 @@
+#ifndef EUDAQ_INCLUDED_TaskExecutor
+#define EUDAQ_INCLUDED_TaskExecutor
+
+#include "eudaq/Platform.hh"
+
+#include <deque>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+
+namespace eudaq {
+
+  /** Fixed pool of worker threads running short tasks.
+   * Every worker owns a deque: tasks submitted by a worker go to its own
+   * deque and are taken back newest first, tasks submitted from outside go
+   * to a shared queue. A worker without tasks steals the oldest task of
+   * another worker before it sleeps; idle workers sleep on a condition
+   * variable instead of polling. Tasks queued when the executor is
+   * destroyed are still run.
+   */
+  class DLLEXPORT TaskExecutor {
+  public:
+    using Task = std::function<void()>;
+    /// zero threads means one per hardware thread
+    explicit TaskExecutor(uint32_t n_threads = 0);
+    ~TaskExecutor();
+    TaskExecutor(const TaskExecutor&) = delete;
+    TaskExecutor &operator=(const TaskExecutor&) = delete;
+
+    /// executor shared by all the processors, its size is taken from the
+    /// environment variable EUDAQ_EXECUTOR_THREADS if set
+    static TaskExecutor &Instance();
+    void Submit(Task t);
+    uint32_t GetThreadN() const {return m_workers.size();};
+    /// true on the threads of this executor, which must not destroy it
+    bool IsWorkerThread() const;
+    uint64_t GetStolenN() const {return m_n_stolen;};
+
+  private:
+    struct Worker {
+      std::mutex mtx;
+      std::deque<Task> que;
+      std::thread th;
+    };
+    void Working(uint32_t i);
+    bool Take(uint32_t i, Task &t);
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::mutex m_mtx; // m_que, sleeping
+    std::condition_variable m_cv;
+    std::deque<Task> m_que;
+    std::atomic<uint64_t> m_n_queued;
+    std::atomic<uint32_t> m_n_idle;
+    std::atomic<uint64_t> m_n_stolen;
+    bool m_stop;
+  };
+}
+
+#endif // EUDAQ_INCLUDED_TaskExecutor
@@ -0,0 +1,117 @@
+#ifndef EUDAQ_INCLUDED_TimestampBuilder
+#define EUDAQ_INCLUDED_TimestampBuilder
+
+#include "eudaq/Event.hh"
+#include "eudaq/Platform.hh"
+
+#include <vector>
+#include <deque>
+#include <set>
+#include <string>
+#include <chrono>
+#include <functional>
+
+namespace eudaq {
+
+  /** Builds events out of the fragments of several streams whose time
+   * intervals [begin, end) overlap, or are less than a window apart.
+   * A stream may deliver its fragments out of order by up to max_delay in
+   * begin time; each stream keeps its fragments sorted and the lowest
+   * begin of all streams is found with a min-heap. The watermark of a
+   * stream is its highest begin seen minus max_delay, nothing older is
+   * expected from it any more. An event is complete once the global
+   * watermark, the lowest one of all active streams, passes its end plus
+   * the window. An event spans at most max_span from its begin, fragments
+   * beginning later go into the next one; without max_span an event is
+   * the slice of its first fragment plus the window, so overlapping
+   * fragments do not chain into events without end. A stream which did
+   * not send anything for idle_ms does not
+   * hold the watermark back until it sends again, removed streams do not
+   * at all. Fragments arriving behind an event already built are late and
+   * discarded. The timestamps of a stream are corrected by its offset
+   * before building. Not thread safe.
+   */
+  class DLLEXPORT TimestampBuilder {
+  public:
+    struct Built {
+      uint64_t begin;
+      uint64_t end;
+      std::vector<EventSPC> frags; // ordered by begin
+    };
+
+    TimestampBuilder();
+    /// a zero idle_ms never excludes a silent stream, a zero max_span
+    /// slices at the first fragment of an event
+    void Configure(uint64_t window, uint64_t max_delay, uint32_t idle_ms,
+		   uint64_t max_span = 0);
+
+    uint32_t AddStream(const std::string &name, int64_t offset = 0);
+    void SetOffset(uint32_t id, int64_t offset);
+    /// the queued fragments of the stream still go into events
+    void RemoveStream(uint32_t id);
+    /// false if the fragment is late and was discarded
+    bool Push(uint32_t id, uint64_t begin, uint64_t end, EventSPC ev);
+    /// Takes the next event which is complete
+    bool Next(Built &out);
+    /// Drops all the queued fragments, the streams are kept
+    void Clear();
+
+    size_t GetStreamN() const {return m_n_streams;};
+    size_t GetPendingN() const {return m_n_pending + m_cur.size();};
+    uint64_t GetBuiltN() const {return m_n_built;};
+    uint64_t GetLateN() const {return m_n_late;};
+    /// largest distance of a late fragment behind the events built
+    uint64_t GetMaxLateness() const {return m_max_lateness;};
+    uint64_t GetWatermark();
+
+  private:
+    using Clock = std::chrono::steady_clock;
+    struct Frag {
+      uint64_t begin;
+      uint64_t end;
+      EventSPC ev;
+    };
+    struct Stream {
+      std::string name;
+      int64_t offset;
+      std::deque<Frag> que; // ordered by begin
+      uint64_t max_begin;
+      uint64_t mark; // watermark of the stream
+      uint64_t listed_mark; // may lag behind mark, see GetWatermark
+      bool has_data;
+      bool listed; // holds the global watermark back
+      bool used;
+      bool active;
+      Clock::time_point t_last;
+    };
+    using Head = std::pair<uint64_t, uint32_t>; // begin of the front, stream
+
+    void List(uint32_t id);
+    void Unlist(uint32_t id);
+    bool TopHead(Head &head);
+    Frag PopHead(uint32_t id);
+    void Release(uint32_t id);
+
+    std::vector<Stream> m_streams;
+    std::vector<uint32_t> m_free;
+    std::vector<Head> m_heap; // may hold outdated heads, checked when on top
+    std::set<std::pair<uint64_t, uint32_t>> m_marks; // listed watermarks
+    std::vector<Frag> m_cur; // event being built
+    uint64_t m_cur_begin;
+    uint64_t m_cur_end;
+    uint64_t m_cur_reach; // end plus window
+    uint64_t m_cur_limit; // the reach does not grow beyond
+    uint64_t m_last_reach; // of the last event built
+    size_t m_n_streams;
+    size_t m_n_pending;
+    uint64_t m_window;
+    uint64_t m_max_delay;
+    uint64_t m_max_span;
+    Clock::duration m_idle;
+    uint64_t m_n_built;
+    uint64_t m_n_late;
+    uint64_t m_max_lateness;
+  };
+}
+
+#endif // EUDAQ_INCLUDED_TimestampBuilder
@@ -8,6 +8,7 @@
 #include "eudaq/Exception.hh"
 #include "eudaq/BufferSerializer.hh"
 #include <string>
+#include <vector>
 #include <queue>
 #include <iosfwd>
 #include <cstring>
@@ -65,7 +66,12 @@ namespace eudaq {
     enum EventType { CONNECT, DISCONNECT, RECEIVE };
     TransportEvent(EventType et, ConnectionSP i, const std::string &p = "")
         : etype(et), id(i), packet(p) {}
+    TransportEvent(EventType et, ConnectionSP i, std::string &&p)
+        : etype(et), id(i), packet(std::move(p)) {}
+    TransportEvent(const TransportEvent &) = default;
+    TransportEvent(TransportEvent &&) = default;
     TransportEvent & operator = (const TransportEvent& rh){etype = rh.etype; id=rh.id;  packet = rh.packet; return *this;};
+    TransportEvent & operator = (TransportEvent &&) = default;
     EventType etype; ///< The type of event
     ConnectionSP id; ///< The id of the connection
     std::string packet; ///< The packet of data in case of a RECEIVE event
@@ -185,6 +191,13 @@ namespace eudaq {
                     bool duringconnect = false) {
       SendPacket(&t[0], t.size(), inf, duringconnect);
     }
+    /** Sends the concatenation of the parts as a single packet.
+     * Transports able to gather the parts in one write should override this,
+     * the default copies them into one buffer first.
+     */
+    virtual void SendPacketParts(const std::vector<BlockView> &parts,
+                                 const ConnectionInfo &inf = ConnectionInfo::ALL,
+                                 bool duringconnect = false);
 
     /** Pure virtual function to close a connection.
      * This function should be implemented by the concrete Transport class to
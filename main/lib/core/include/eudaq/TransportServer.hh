@@ -21,6 +21,10 @@ namespace eudaq {
     ~TransportServer() override;
     virtual std::string ConnectionString() const = 0;
     virtual std::vector<ConnectionSPC> GetConnections() const = 0;
+    /// Stops (or resumes) reading from a connection, so that the sender gets
+    /// slowed down by the flow control of the transport. Transports without
+    /// such a mechanism ignore it.
+    virtual void PauseReceive(const ConnectionInfo &/*id*/, bool /*pause*/) {}
     static TransportServer* CreateServer(const std::string &name);
   };
 }
@@ -18,6 +18,9 @@ typedef int SOCKET;
 #include <vector>
 #include <string>
 #include <map>
+#include <deque>
+#include <atomic>
+#include <mutex>
 
 namespace eudaq {
   class ConnectionInfoTCP : public ConnectionInfo {
@@ -26,21 +29,41 @@ namespace eudaq {
     ConnectionInfoTCP(const ConnectionInfoTCP&) = delete;
     ConnectionInfoTCP& operator = (const ConnectionInfoTCP&) = delete;   
     ConnectionInfoTCP(SOCKET fd, const std::string &host = "")
-      : m_fd(fd), m_host(host), m_len(0), m_buf(""), ConnectionInfo("") {}
+      : ConnectionInfo(""), m_fd(fd), m_host(host), m_hdr_got(0), m_len(0),
+        m_got(0), m_paused(false), m_closed(false) {}
     void append(size_t length, const char *data);
+    /// Returns where the payload of the current packet continues, so that a
+    /// large packet is received straight into its final storage, or nullptr
+    /// if less than min bytes of it are missing.
+    char *direct(size_t &length, size_t min);
+    void commit(size_t length);
     bool havepacket() const;
     std::string getpacket();
     SOCKET GetFd() const { return m_fd; }
+    bool IsPaused() const { return m_paused; }
+    void SetPaused(bool paused) { m_paused = paused; }
+    /// Held while sending and while closing, so that the socket, and its
+    /// number, is not reused by a new connection during a send
+    std::mutex &SendMutex() { return m_mtx_send; }
+    bool IsClosed() const { return m_closed; }
+    void SetClosed() { m_closed = true; }
     bool Matches(const ConnectionInfo &other) const override;
     void Print(std::ostream &, size_t) const override;
     std::string GetRemote() const override { return m_host; }
 
   private:
-    void update_length(bool = false);
+    void grow(size_t need);
     SOCKET m_fd;
     std::string m_host;
+    unsigned char m_hdr[4]; // length prefix of the packet being received
+    size_t m_hdr_got;
     size_t m_len;
-    std::string m_buf;
+    size_t m_got;
+    std::string m_pkt; // packet being received, grown as the data arrives
+    std::deque<std::string> m_ready;
+    std::atomic<bool> m_paused;
+    std::mutex m_mtx_send;
+    std::atomic<bool> m_closed;
   };
   
   class TCPServer : public TransportServer {
@@ -51,20 +74,33 @@ namespace eudaq {
     void SendPacket(const unsigned char *data, size_t len,
 		    const ConnectionInfo &id = ConnectionInfo::ALL,
 		    bool duringconnect = false) override;
+    void SendPacketParts(const std::vector<BlockView> &parts,
+                         const ConnectionInfo &id = ConnectionInfo::ALL,
+                         bool duringconnect = false) override;
     void ProcessEvents(int timeout) override;
     std::string ConnectionString() const override;
     std::vector<ConnectionSPC> GetConnections() const  override;
+    void PauseReceive(const ConnectionInfo &id, bool pause) override;
     static const std::string name;
   private:
     std::vector<std::shared_ptr<ConnectionInfoTCP>> m_conn;
-    std::mutex m_mtx_conn;
+    mutable std::mutex m_mtx_conn;
     
     int m_port;
     SOCKET m_srvsock;
+#if EUDAQ_PLATFORM_IS(LINUX)
+    int m_epfd; // edge-triggered epoll instance watching all the sockets
+#else
     SOCKET m_maxfd;
     fd_set m_fdset;
+#endif
+
+    std::vector<char> m_rdbuf;
 
     std::shared_ptr<ConnectionInfoTCP> GetInfo(SOCKET fd) const;
+    std::vector<std::shared_ptr<ConnectionInfoTCP>> Matching(const ConnectionInfo &id) const;
+    void Accept();
+    bool Receive(SOCKET fd);
   };
 
   class TCPClient : public TransportClient {
@@ -75,6 +111,9 @@ namespace eudaq {
     virtual void SendPacket(const unsigned char *data, size_t len,
                             const ConnectionInfo &id = ConnectionInfo::ALL,
                             bool = false);
+    void SendPacketParts(const std::vector<BlockView> &parts,
+                         const ConnectionInfo &id = ConnectionInfo::ALL,
+                         bool = false) override;
     virtual void ProcessEvents(int timeout = -1);
     static const std::string name;
   private:
@@ -83,6 +122,7 @@ namespace eudaq {
     int m_port;
     SOCKET m_sock;
     std::shared_ptr<ConnectionInfoTCP> m_buf;
+    std::vector<char> m_rdbuf;
   };
 }
 
@@ -1,4 +1,6 @@
 #include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <sys/ioctl.h>
 #include <netdb.h>
 #include <arpa/inet.h>
@@ -107,6 +109,9 @@ namespace eudaq {
       ling.l_onoff = 1; ///< Enable linger mode
       ling.l_linger = 1; ///< Linger timeout in seconds
       setsockopt(sock, SOL_SOCKET, SO_LINGER, &ling, sizeof ling);
+
+      /// Packets go out in a single send, do not hold them back
+      setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
     }
 
   }
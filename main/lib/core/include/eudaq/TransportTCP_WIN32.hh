@@ -124,6 +124,9 @@ namespace eudaq {
     static void setup_socket(SOCKET sock) {
       unsigned long one = 1;
       ioctlsocket(sock, FIONBIO, &one);
+      BOOL nodelay = TRUE;
+      setsockopt(sock, IPPROTO_TCP, TCP_NODELAY,
+                 reinterpret_cast<const char *>(&nodelay), sizeof nodelay);
     }
 
     class WSAHelper {
@@ -0,0 +1,131 @@
+#include "eudaq/AsyncFileSerializer.hh"
+#include "eudaq/Logger.hh"
+#include "eudaq/Utils.hh"
+
+#include <cstring>
+#include <cerrno>
+
+namespace eudaq {
+  AsyncFileSerializer::AsyncFileSerializer(const std::string &fname, bool overwrite,
+                                           uint64_t flush_bytes, uint32_t flush_ms,
+                                           uint64_t max_pending)
+    : m_file(0), m_fname(fname), m_flush_bytes(flush_bytes),
+      m_flush_ms(flush_ms), m_max_pending(max_pending),
+      m_pending(0), m_accepted(0),
+      m_busy(false), m_exit(false), m_warned(false) {
+    if (!overwrite) {
+      FILE *fd = fopen(fname.c_str(), "rb");
+      if (fd) {
+        fclose(fd);
+        EUDAQ_THROWX(FileExistsException, "File already exists: " + fname);
+      }
+    }
+    m_file = fopen(fname.c_str(), "wb");
+    if (!m_file)
+      EUDAQ_THROWX(FileNotFoundException, "Unable to open file: " + fname);
+    // the batches are written in one go, stdio buffering would only add a copy
+    setvbuf(m_file, nullptr, _IONBF, 0);
+    NewBatch();
+    m_thd = std::thread(&AsyncFileSerializer::IOThread, this);
+  }
+
+  AsyncFileSerializer::~AsyncFileSerializer() {
+    {
+      std::unique_lock<std::mutex> lk(m_mtx);
+      HandOver(lk);
+      m_exit = true;
+    }
+    m_cv_io.notify_all();
+    if (m_thd.joinable())
+      m_thd.join();
+    if (!m_error.empty())
+      EUDAQ_ERROR(m_error);
+    fclose(m_file);
+  }
+
+  uint64_t AsyncFileSerializer::Write(const Serializable &obj) {
+    std::unique_lock<std::mutex> lk(m_mtx);
+    if (!m_error.empty())
+      EUDAQ_THROW(m_error);
+    // the IO thread sleeps without a timeout while the batch is empty, the
+    // first data starts the flush timer
+    bool first = m_front->size() == 0;
+    if (first)
+      m_front_time = std::chrono::steady_clock::now();
+    uint64_t offset = m_accepted;
+    size_t before = m_front->size();
+    obj.Serialize(*m_front);
+    m_accepted += m_front->size() - before;
+    if (m_front->size() >= m_flush_bytes)
+      HandOver(lk);
+    else if (first)
+      m_cv_io.notify_all();
+    return offset;
+  }
+
+  void AsyncFileSerializer::Flush() {
+    std::unique_lock<std::mutex> lk(m_mtx);
+    HandOver(lk);
+    m_cv_done.wait(lk, [this] { return (m_queue.empty() && !m_busy) || !m_error.empty(); });
+    if (!m_error.empty())
+      EUDAQ_THROW(m_error);
+  }
+
+  void AsyncFileSerializer::HandOver(std::unique_lock<std::mutex> &lk) {
+    if (m_front->size() == 0)
+      return;
+    if (m_pending + m_front->size() > m_max_pending && m_pending) {
+      if (!m_warned) {
+        EUDAQ_WARN("AsyncFileSerializer: disk is slower than the data rate, "
+                   "waiting for " + m_fname);
+        m_warned = true;
+      }
+      m_cv_done.wait(lk, [this] {
+        return m_pending + m_front->size() <= m_max_pending || !m_pending ||
+          !m_error.empty();
+      });
+    }
+    m_pending += m_front->size();
+    m_queue.push_back(std::move(m_front));
+    NewBatch();
+    m_cv_io.notify_all();
+  }
+
+  void AsyncFileSerializer::NewBatch() {
+    // avoid regrowing the batch while it is filled up to the flush threshold
+    std::vector<unsigned char> buf;
+    buf.reserve(m_flush_bytes + (m_flush_bytes >> 3));
+    m_front.reset(new BufferSerializer(std::move(buf)));
+  }
+
+  void AsyncFileSerializer::IOThread() {
+    std::unique_lock<std::mutex> lk(m_mtx);
+    while (true) {
+      if (m_queue.empty()) {
+        if (m_exit)
+          break;
+        if (m_front->size() == 0)
+          m_cv_io.wait(lk);
+        else if (m_cv_io.wait_until(lk, m_front_time + m_flush_ms) ==
+                 std::cv_status::timeout && m_front->size())
+          HandOver(lk);
+        continue;
+      }
+      std::unique_ptr<BufferSerializer> batch = std::move(m_queue.front());
+      m_queue.pop_front();
+      m_busy = true;
+      lk.unlock();
+      size_t len = batch->size();
+      size_t written = std::fwrite(&(*batch)[0], 1, len, m_file);
+      int err = errno;
+      std::fflush(m_file);
+      lk.lock();
+      m_busy = false;
+      m_pending -= len;
+      if (written != len && m_error.empty())
+        m_error = "Error writing to file " + m_fname + ": " + to_string(err) +
+          ", " + strerror(err);
+      m_cv_done.notify_all();
+    }
+  }
+}
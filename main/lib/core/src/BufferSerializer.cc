@@ -2,44 +2,95 @@
 
 namespace eudaq {
 
-  BufferSerializer::BufferSerializer(Deserializer &des) : m_offset(0) {
-    des.read(m_data);
+  BufferSerializer::BufferSerializer(Deserializer &des)
+    : m_data(std::make_shared<std::vector<unsigned char>>()) {
+    des.read(*m_data);
+    SetDirectBuffer();
   }
 
-  void BufferSerializer::Serialize(Serializer &ser) const { ser.write(m_data); }
+  BufferSerializer::BufferSerializer(const BufferSerializer &other)
+    : m_data(std::make_shared<std::vector<unsigned char>>(*other.m_data)) {
+    m_rd_pos = other.m_rd_pos;
+    SetDirectBuffer();
+  }
+
+  BufferSerializer &BufferSerializer::operator=(const BufferSerializer &other) {
+    if (this != &other) {
+      m_data = std::make_shared<std::vector<unsigned char>>(*other.m_data);
+      m_rd_pos = other.m_rd_pos;
+      SetDirectBuffer();
+    }
+    return *this;
+  }
+
+  BufferSerializer::BufferSerializer(BufferSerializer &&other)
+    : m_data(std::move(other.m_data)) {
+    m_rd_pos = other.m_rd_pos;
+    SetDirectBuffer();
+    if (m_data.use_count() > 1)
+      Serializer::m_wr_buf = nullptr;
+    other.m_data = std::make_shared<std::vector<unsigned char>>();
+    other.m_rd_pos = 0;
+    other.SetDirectBuffer();
+  }
+
+  BufferSerializer &BufferSerializer::operator=(BufferSerializer &&other) {
+    if (this != &other) {
+      m_data = std::move(other.m_data);
+      m_rd_pos = other.m_rd_pos;
+      SetDirectBuffer();
+      if (m_data.use_count() > 1)
+        Serializer::m_wr_buf = nullptr;
+      other.m_data = std::make_shared<std::vector<unsigned char>>();
+      other.m_rd_pos = 0;
+      other.SetDirectBuffer();
+    }
+    return *this;
+  }
+
+  void BufferSerializer::Serialize(Serializer &ser) const { ser.write(*m_data); }
 
   void BufferSerializer::Serialize(const unsigned char *data, size_t len) {
-    m_data.insert(m_data.end(), data, data + len);
+    if (m_data.use_count() > 1) {
+      // DataBlocks still refer to the current storage, do not reallocate it
+      m_data = std::make_shared<std::vector<unsigned char>>(*m_data);
+      SetDirectBuffer();
+    }
+    m_data->insert(m_data->end(), data, data + len);
   }
 
   void BufferSerializer::Deserialize(unsigned char *data, size_t len) {
     if (!len)
       return;
-    if (len + m_offset > m_data.size()) {
+    if (len + m_rd_pos > m_data->size()) {
       EUDAQ_THROW("Deserialize asked for " + to_string(len) + ", only have " +
-                  to_string(m_data.size() - m_offset));
+                  to_string(m_data->size() - m_rd_pos));
     }
-    std::copy(&m_data[m_offset], &m_data[m_offset] + len, data);
-    // m_data.erase(m_data.begin(), m_data.begin() + len);
-    m_offset += len;
-    // std::string tmp(data, data+len);
-    // std::cout << "Deserialize: " << len << /*" \"" << tmp << "\"" <<*/
-    // std::endl;
-    // tmp = std::string(begin(), end());
-    // std::cout << "Remaining: " << (end()-begin()) << /*" \"" << tmp << "\""
-    // <<*/ std::endl;
+    std::copy(&(*m_data)[m_rd_pos], &(*m_data)[m_rd_pos] + len, data);
+    m_rd_pos += len;
   }
 
 
   void BufferSerializer::PreDeserialize(unsigned char *data, size_t len) {
     if (!len)
       return;
-    if (len + m_offset > m_data.size()) {
+    if (len + m_rd_pos > m_data->size()) {
       EUDAQ_THROW("Deserialize asked for " + to_string(len) + ", only have " +
-                  to_string(m_data.size() - m_offset));
+                  to_string(m_data->size() - m_rd_pos));
     }
-    std::copy(&m_data[m_offset], &m_data[m_offset] + len, data);
+    std::copy(&(*m_data)[m_rd_pos], &(*m_data)[m_rd_pos] + len, data);
   }
 
+  DataBlock BufferSerializer::DeserializeBlock(size_t len) {
+    if (len + m_rd_pos > m_data->size()) {
+      EUDAQ_THROW("Deserialize asked for " + to_string(len) + ", only have " +
+                  to_string(m_data->size() - m_rd_pos));
+    }
+    DataBlock block(m_data, m_rd_pos, len);
+    m_rd_pos += len;
+    // appending must now go through Serialize() which copies on write
+    Serializer::m_wr_buf = nullptr;
+    return block;
+  }
 
 }
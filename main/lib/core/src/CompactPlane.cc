@@ -0,0 +1,329 @@
+#include "eudaq/CompactPlane.hh"
+#include "eudaq/Exception.hh"
+
+#include <cmath>
+#include <cstring>
+#include <ostream>
+
+namespace eudaq{
+  namespace{
+    bool FitsInt(double v, double max){
+      return v >= 0 && v <= max && v == std::floor(v);
+    }
+  }
+
+  const uint32_t CompactPlane::VERSION;
+
+  uint32_t CompactPlane::FrameView::Charge(uint32_t i) const {
+    switch(charge_bytes){
+    case 0: return 1;
+    case 1: return charge[i];
+    case 2: return charge[2*i] | (uint32_t(charge[2*i+1]) << 8);
+    default:
+      return charge[4*i] | (uint32_t(charge[4*i+1]) << 8) |
+	(uint32_t(charge[4*i+2]) << 16) | (uint32_t(charge[4*i+3]) << 24);
+    }
+  }
+
+  CompactPlane::CompactPlane()
+    :m_id(0), m_xsize(0), m_ysize(0), m_flags(0), m_pivotpixel(0),
+     m_charge_bytes(0), m_with_time(false), m_offset(1, 0){
+  }
+
+  CompactPlane::CompactPlane(uint32_t id, const std::string &type,
+			     const std::string &sensor, uint32_t charge_bytes,
+			     bool with_time)
+    :m_type(type), m_sensor(sensor), m_id(id), m_xsize(0), m_ysize(0),
+     m_flags(0), m_pivotpixel(0), m_charge_bytes(charge_bytes),
+     m_with_time(with_time), m_offset(1, 0){
+    if(charge_bytes != 0 && charge_bytes != 1 && charge_bytes != 2 && charge_bytes != 4)
+      EUDAQ_THROW("CompactPlane: Charge of " + to_string(charge_bytes) + " bytes");
+  }
+
+  CompactPlane::CompactPlane(Deserializer &ds){
+    uint32_t version;
+    ds.read(version);
+    if(version > VERSION)
+      EUDAQ_THROW("CompactPlane: Unknown version " + to_string(version));
+    ds.read(m_type);
+    ds.read(m_sensor);
+    ds.read(m_id);
+    ds.read(m_xsize);
+    ds.read(m_ysize);
+    ds.read(m_flags);
+    ds.read(m_pivotpixel);
+    ds.read(m_charge_bytes);
+    uint8_t with_time;
+    ds.read(with_time);
+    m_with_time = with_time;
+    ds.read(m_offset);
+    ds.read(m_x);
+    ds.read(m_y);
+    ds.read(m_charge);
+    ds.read(m_time);
+    ds.read(m_pivot);
+    ds.read(m_mat);
+    size_t n = m_x.size();
+    if(m_offset.empty() || m_offset.back() != n || m_y.size() != n ||
+       m_charge.size() != n * m_charge_bytes || (m_with_time && m_time.size() != n) ||
+       (GetFlags(StandardPlane::FLAG_WITHPIVOT) ? m_pivot.size() != n : !m_pivot.empty()))
+      EUDAQ_THROW("CompactPlane: Inconsistent plane " + to_string(m_id));
+  }
+
+  CompactPlane::CompactPlane(const StandardPlane &p)
+    :m_type(p.m_type), m_sensor(p.m_sensor), m_id(p.m_id), m_xsize(p.m_xsize),
+     m_ysize(p.m_ysize), m_flags(p.m_flags), m_pivotpixel(p.m_pivotpixel),
+     m_charge_bytes(0), m_with_time(!p.m_time.empty()), m_mat(p.m_mat){
+    if(!Fits(p))
+      EUDAQ_THROW("CompactPlane: Plane " + to_string(p.m_id) + " does not fit");
+    double max = 0;
+    bool all_one = true;
+    size_t n = 0;
+    for(auto &f: p.m_pix){
+      for(auto v: f){
+	if(v > max)
+	  max = v;
+	all_one = all_one && v == 1;
+      }
+      n += f.size();
+    }
+    m_charge_bytes = all_one ?0 :(max < 0x100 ?1 :(max < 0x10000 ?2 :4));
+    Reserve(n);
+    uint32_t frames = p.m_pix.size();
+    m_offset.assign(frames + 1, 0);
+    bool diff = p.m_x.size() > 1;
+    for(uint32_t f = 0; f < frames; f++){
+      auto &x = p.m_x[diff ?f :0];
+      auto &y = p.m_y[diff ?f :0];
+      auto &pix = p.m_pix[f];
+      const std::vector<bool> *pivot = p.m_pivot.empty() ?nullptr :&p.m_pivot[diff ?f :0];
+      const std::vector<uint64_t> *time = p.m_time.empty() ?nullptr :&p.m_time[diff ?f :0];
+      for(size_t i = 0; i < pix.size(); i++)
+	PushPixel(uint16_t(x[i]), uint16_t(y[i]), uint32_t(pix[i]), f,
+		  time ?(*time)[i] :0, pivot && (*pivot)[i]);
+    }
+  }
+
+  void CompactPlane::Serialize(Serializer &ser) const {
+    ser.write(VERSION);
+    ser.write(m_type);
+    ser.write(m_sensor);
+    ser.write(m_id);
+    ser.write(m_xsize);
+    ser.write(m_ysize);
+    ser.write(m_flags);
+    ser.write(m_pivotpixel);
+    ser.write(m_charge_bytes);
+    ser.write(uint8_t(m_with_time));
+    ser.write(m_offset);
+    ser.write(m_x);
+    ser.write(m_y);
+    ser.write(m_charge);
+    ser.write(m_time);
+    ser.write(m_pivot);
+    ser.write(m_mat);
+  }
+
+  bool CompactPlane::Fits(const StandardPlane &p){
+    size_t frames = p.m_pix.size();
+    if(!frames || p.m_x.size() != p.m_y.size())
+      return false;
+    bool diff = p.m_x.size() > 1;
+    if(diff && p.m_x.size() != frames)
+      return false;
+    if(p.GetFlags(StandardPlane::FLAG_WITHPIVOT) ? p.m_pivot.size() != p.m_x.size()
+       : !p.m_pivot.empty())
+      return false;
+    if(p.GetFlags(StandardPlane::FLAG_WITHTIME) ? p.m_time.size() != p.m_x.size()
+       : !p.m_time.empty())
+      return false;
+    for(size_t k = 0; k < p.m_x.size(); k++){
+      if(p.m_y[k].size() != p.m_x[k].size() ||
+	 (!p.m_pivot.empty() && p.m_pivot[k].size() != p.m_x[k].size()) ||
+	 (!p.m_time.empty() && p.m_time[k].size() != p.m_x[k].size()))
+	return false;
+      for(size_t i = 0; i < p.m_x[k].size(); i++)
+	if(!FitsInt(p.m_x[k][i], 0xFFFF) || !FitsInt(p.m_y[k][i], 0xFFFF))
+	  return false;
+    }
+    for(size_t f = 0; f < frames; f++){
+      if(p.m_pix[f].size() != p.m_x[diff ?f :0].size())
+	return false;
+      for(auto v: p.m_pix[f])
+	if(!FitsInt(v, 0xFFFFFFFF))
+	  return false;
+    }
+    return true;
+  }
+
+  StandardPlane CompactPlane::ToStandardPlane() const {
+    StandardPlane p(m_id, m_type, m_sensor);
+    Unpack(p);
+    return p;
+  }
+
+  void CompactPlane::Unpack(StandardPlane &p) const {
+    p.m_type = m_type;
+    p.m_sensor = m_sensor;
+    p.m_id = m_id;
+    p.m_xsize = m_xsize;
+    p.m_ysize = m_ysize;
+    p.m_flags = m_with_time ?m_flags | StandardPlane::FLAG_WITHTIME
+      :m_flags & ~StandardPlane::FLAG_WITHTIME;
+    p.m_pivotpixel = m_pivotpixel;
+    p.m_mat = m_mat;
+    uint32_t frames = NumFrames();
+    bool diff = GetFlags(StandardPlane::FLAG_DIFFCOORDS) || frames == 1;
+    uint32_t coords = diff ?frames :1;
+    p.m_pix.assign(frames, std::vector<StandardPlane::pixel_t>());
+    p.m_x.assign(coords, std::vector<StandardPlane::coord_t>());
+    p.m_y.assign(coords, std::vector<StandardPlane::coord_t>());
+    p.m_pivot.assign(GetFlags(StandardPlane::FLAG_WITHPIVOT) ?coords :0, std::vector<bool>());
+    p.m_time.assign(m_with_time ?coords :0, std::vector<uint64_t>());
+    for(uint32_t f = 0; f < frames; f++){
+      FrameView v = Frame(f);
+      auto &pix = p.m_pix[f];
+      pix.resize(v.n);
+      for(uint32_t i = 0; i < v.n; i++)
+	pix[i] = v.Charge(i);
+      if(f >= coords)
+	continue;
+      p.m_x[f].assign(v.x, v.x + v.n);
+      p.m_y[f].assign(v.y, v.y + v.n);
+      if(v.pivot)
+	p.m_pivot[f].assign(v.pivot, v.pivot + v.n);
+      if(v.time)
+	p.m_time[f].assign(v.time, v.time + v.n);
+    }
+  }
+
+  void CompactPlane::SetSize(uint32_t w, uint32_t h, uint32_t frames, int flags){
+    m_xsize = w;
+    m_ysize = h;
+    m_flags = flags | StandardPlane::FLAG_ZS | StandardPlane::FLAG_DIFFCOORDS;
+    m_offset.assign(frames + 1, 0);
+    m_x.clear();
+    m_y.clear();
+    m_charge.clear();
+    m_time.clear();
+    m_pivot.clear();
+  }
+
+  void CompactPlane::Reserve(uint32_t npix){
+    m_x.reserve(npix);
+    m_y.reserve(npix);
+    m_charge.reserve(size_t(npix) * m_charge_bytes);
+    if(GetFlags(StandardPlane::FLAG_WITHPIVOT))
+      m_pivot.reserve(npix);
+    if(m_with_time)
+      m_time.reserve(npix);
+  }
+
+  void CompactPlane::PushPixel(uint16_t x, uint16_t y, uint32_t charge,
+			       uint32_t frame, uint64_t time, bool pivot){
+    uint32_t frames = NumFrames();
+    if(frame >= frames || m_offset[frame + 1] != m_x.size())
+      EUDAQ_THROW("CompactPlane: Bad frame number " + to_string(frame) + " in PushPixel");
+    m_x.push_back(x);
+    m_y.push_back(y);
+    for(uint32_t b = 0; b < m_charge_bytes; b++)
+      m_charge.push_back(uint8_t(charge >> (8 * b)));
+    if(m_with_time)
+      m_time.push_back(time);
+    if(GetFlags(StandardPlane::FLAG_WITHPIVOT))
+      m_pivot.push_back(pivot);
+    // the following frames start after this hit
+    for(uint32_t f = frame + 1; f <= frames; f++)
+      m_offset[f] = m_x.size();
+  }
+
+  void CompactPlane::PushPixels(uint32_t frame, const uint16_t *x, const uint16_t *y,
+				uint32_t n, const uint8_t *pivot){
+    uint32_t frames = NumFrames();
+    if(frame >= frames || m_offset[frame + 1] != m_x.size())
+      EUDAQ_THROW("CompactPlane: Bad frame number " + to_string(frame) + " in PushPixels");
+    m_x.insert(m_x.end(), x, x + n);
+    m_y.insert(m_y.end(), y, y + n);
+    if(m_charge_bytes){
+      size_t b = m_charge.size();
+      m_charge.resize(b + size_t(n) * m_charge_bytes, 0);
+      for(size_t i = b; i < m_charge.size(); i += m_charge_bytes)
+	m_charge[i] = 1;
+    }
+    if(m_with_time)
+      m_time.resize(m_x.size(), 0);
+    if(GetFlags(StandardPlane::FLAG_WITHPIVOT)){
+      if(pivot)
+	m_pivot.insert(m_pivot.end(), pivot, pivot + n);
+      else
+	m_pivot.resize(m_x.size(), 0);
+    }
+    for(uint32_t f = frame + 1; f <= frames; f++)
+      m_offset[f] = m_x.size();
+  }
+
+  CompactPlane::FrameView CompactPlane::Frame(uint32_t frame) const {
+    if(frame >= NumFrames())
+      EUDAQ_THROW("CompactPlane: Bad frame number " + to_string(frame));
+    uint32_t b = m_offset[frame];
+    FrameView v;
+    v.n = m_offset[frame + 1] - b;
+    v.x = m_x.data() + b;
+    v.y = m_y.data() + b;
+    v.charge_bytes = m_charge_bytes;
+    v.charge = m_charge_bytes ?m_charge.data() + size_t(b) * m_charge_bytes :nullptr;
+    v.time = m_with_time ?m_time.data() + b :nullptr;
+    v.pivot = GetFlags(StandardPlane::FLAG_WITHPIVOT) ?m_pivot.data() + b :nullptr;
+    return v;
+  }
+
+  uint32_t CompactPlane::HitPixels(uint32_t frame) const {
+    return Frame(frame).n;
+  }
+
+  int CompactPlane::Polarity() const {
+    return GetFlags(StandardPlane::FLAG_NEGATIVE) ? -1 : 1;
+  }
+
+  uint32_t CompactPlane::At(uint32_t index, uint32_t frame) const {
+    if(frame >= NumFrames() || index >= m_offset[frame + 1] - m_offset[frame])
+      EUDAQ_THROW("CompactPlane: No pixel " + to_string(index) + " in frame " + to_string(frame));
+    return m_offset[frame] + index;
+  }
+
+  double CompactPlane::GetX(uint32_t index, uint32_t frame) const {
+    return m_x[At(index, frame)];
+  }
+
+  double CompactPlane::GetY(uint32_t index, uint32_t frame) const {
+    return m_y[At(index, frame)];
+  }
+
+  double CompactPlane::GetPixel(uint32_t index, uint32_t frame) const {
+    FrameView v = Frame(frame);
+    return v.Charge(At(index, frame) - m_offset[frame]);
+  }
+
+  bool CompactPlane::GetPivot(uint32_t index, uint32_t frame) const {
+    uint32_t i = At(index, frame);
+    return GetFlags(StandardPlane::FLAG_WITHPIVOT) && m_pivot[i];
+  }
+
+  uint64_t CompactPlane::GetTime(uint32_t index, uint32_t frame) const {
+    uint32_t i = At(index, frame);
+    return m_with_time ?m_time[i] :0;
+  }
+
+  size_t CompactPlane::HitBytes() const {
+    return m_x.size() * sizeof(uint16_t) * 2 + m_charge.size() +
+      m_time.size() * sizeof(uint64_t) + m_pivot.size() +
+      m_offset.size() * sizeof(uint32_t);
+  }
+
+  void CompactPlane::Print(std::ostream &os, size_t offset) const {
+    os << std::string(offset, ' ') << m_id << ", " << m_type << ":" << m_sensor << ", "
+       << m_xsize << "x" << m_ysize << "x" << NumFrames() << " (" << m_x.size()
+       << " hits, " << m_charge_bytes << " byte charge" << (m_with_time ?", time" :"")
+       << "), pivot=" << m_pivotpixel;
+  }
+}
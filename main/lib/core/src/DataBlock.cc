@@ -0,0 +1,42 @@
+#include "eudaq/DataBlock.hh"
+
+namespace eudaq {
+
+  DataBlock::DataBlock()
+    :m_size(0){
+  }
+
+  DataBlock::DataBlock(std::vector<uint8_t> &&data)
+    :m_size(data.size()){
+    auto buf = std::make_shared<const std::vector<uint8_t>>(std::move(data));
+    m_ptr = std::shared_ptr<const uint8_t>(buf, buf->data());
+  }
+
+  DataBlock::DataBlock(const uint8_t *data, size_t size)
+    :DataBlock(std::vector<uint8_t>(data, data + size)){
+  }
+
+  DataBlock::DataBlock(std::shared_ptr<const std::vector<uint8_t>> buf,
+                       size_t offset, size_t size)
+    :m_size(size){
+    if(offset + size > buf->size())
+      EUDAQ_THROW("DataBlock: slice exceeds the size of the buffer");
+    m_ptr = std::shared_ptr<const uint8_t>(buf, buf->data() + offset);
+  }
+
+  DataBlock::DataBlock(std::shared_ptr<const uint8_t> ptr, size_t size)
+    :m_ptr(std::move(ptr)), m_size(size){
+  }
+
+  DataBlock::DataBlock(Deserializer &ds)
+    :m_size(0){
+    uint32_t len = 0;
+    ds.read(len);
+    *this = ds.ReadBlock(len);
+  }
+
+  void DataBlock::Serialize(Serializer &ser) const {
+    ser.write((uint32_t)m_size);
+    ser.append_block(m_ptr.get(), m_size);
+  }
+}
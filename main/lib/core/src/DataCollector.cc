@@ -51,6 +51,11 @@ namespace eudaq {
   void DataCollector::DoReceive(ConnectionSPC id, EventSP ev){
   }
 
+  void DataCollector::DoReceiveEvents(ConnectionSPC id, std::vector<EventSP> &evs){
+    for(auto &ev: evs)
+      DoReceive(id, ev);
+  }
+
   void DataCollector::SetServerAddress(const std::string &addr){
     m_data_addr = addr;
   }
@@ -81,6 +86,10 @@ namespace eudaq {
       m_fwpatt = conf->Get("EUDAQ_FW_PATTERN", "$12D_run$6R$X");
       m_dct_n = conf->Get("EUDAQ_ID", m_dct_n);
       m_fraction = conf->Get("EUDAQ_DATACOL_SEND_MONITOR_FRACTION", 10);
+      SetFlowControl(conf->Get("EUDAQ_DATACOL_FLOW", "block"),
+		     conf->Get("EUDAQ_DATACOL_QUEUE_BYTES", uint64_t(256) << 20),
+		     conf->Get("EUDAQ_DATACOL_SPILL_DIR", ""));
+      SetDecodeThreads(conf->Get("EUDAQ_DATACOL_DECODE_THREADS", -1));
       DoConfigure();
       CommandReceiver::OnConfigure();
     }catch (const Exception &e) {
@@ -95,24 +104,46 @@ namespace eudaq {
     try {
       m_data_addr = Listen(m_data_addr);
       SetStatusTag("_SERVER", m_data_addr);
-      m_writer = Factory<FileWriter>::Create<std::string&>(str2hash(m_fwtype), m_fwpatt);
+      // with several shards, EUDAQ_FW is the writer of each shard
+      std::string fwtype = m_fwtype;
+      if(GetConfiguration()->Get("EUDAQ_FW_SHARDS", 1) > 1)
+	fwtype = "shards";
+      m_writer = Factory<FileWriter>::Create<std::string&>(str2hash(fwtype), m_fwpatt);
+      if(m_writer)
+	m_writer->SetConfiguration(GetConfiguration());
       m_evt_c = 0;
 
-      std::string mn_str = GetConfiguration()->Get("EUDAQ_MN", "");
+      auto conf = GetConfiguration();
+      std::string mn_str = conf->Get("EUDAQ_MN", "");
       std::vector<std::string> col_mn_name = split(mn_str, ";,", true);
-      std::string cur_backup = GetConfiguration()->GetCurrentSectionName();
-      GetConfiguration()->SetSection("");
-      for(auto &mn_name: col_mn_name){
-	std::string mn_addr =  GetConfiguration()->Get("Monitor."+mn_name, "");
-	std::unique_lock<std::mutex> lk(m_mtx_sender);
-	if(!mn_addr.empty()){
-	  m_senders[mn_addr]
-	    = std::shared_ptr<DataSender>(new DataSender("DataCollector", GetName()));
-	  m_senders[mn_addr]->Connect(mn_addr);
-	}
-	lk.unlock();
+      std::string cur_backup = conf->GetCurrentSectionName();
+      conf->SetSection("");
+      std::vector<std::string> col_mn_addr;
+      for(auto &mn_name: col_mn_name)
+	col_mn_addr.push_back(conf->Get("Monitor." + mn_name, ""));
+      conf->SetSection(cur_backup);
+      // every monitor gets its own queue and sending thread, so a slow one
+      // only loses events instead of holding up the data taking
+      uint64_t depth = conf->Get("EUDAQ_DATACOL_MN_QUEUE", uint64_t(64));
+      std::string drop = conf->Get("EUDAQ_DATACOL_MN_DROP", "oldest");
+      uint32_t drain_ms = conf->Get("EUDAQ_DATACOL_MN_DRAIN_MS", uint32_t(1000));
+      std::shared_ptr<MonitorSenders> senders(new MonitorSenders);
+      for(size_t i = 0; i < col_mn_name.size(); i++){
+	if(col_mn_addr[i].empty())
+	  continue;
+	std::string &mn_name = col_mn_name[i];
+	MonitorSender mn;
+	mn.name = mn_name;
+	mn.fraction = conf->Get("EUDAQ_DATACOL_MN_FRACTION_" + mn_name, int(m_fraction));
+	mn.sender.reset(new DataSender("DataCollector", GetName()));
+	mn.sender->SetQueue(conf->Get("EUDAQ_DATACOL_MN_QUEUE_" + mn_name, depth),
+			    conf->Get("EUDAQ_DATACOL_MN_DROP_" + mn_name, drop), drain_ms);
+	mn.sender->Connect(col_mn_addr[i]);
+	senders->push_back(mn);
       }
-      GetConfiguration()->SetSection(cur_backup);
+      std::unique_lock<std::mutex> lk(m_mtx_sender);
+      m_senders = senders;
+      lk.unlock();
       DoStartRun();
       CommandReceiver::OnStartRun();
     } catch (const Exception &e) {
@@ -127,8 +158,10 @@ namespace eudaq {
     try {
       DoStopRun();
       std::unique_lock<std::mutex> lk(m_mtx_sender);
-      m_senders.clear();
+      auto senders = std::move(m_senders);
       lk.unlock();
+      // the senders send what they queued, the EORE included, out of the lock
+      senders.reset();
       StopListen();
       CommandReceiver::OnStopRun();
     } catch (const Exception &e) {
@@ -143,7 +176,7 @@ namespace eudaq {
     try{
       DoReset();
       std::unique_lock<std::mutex> lk(m_mtx_sender);
-      m_senders.clear();
+      m_senders.reset();
       lk.unlock();
       StopListen();
       CommandReceiver::OnReset();
@@ -164,7 +197,21 @@ namespace eudaq {
     
   void DataCollector::OnStatus(){
     SetStatusTag("EventN", std::to_string(m_evt_c));
-    SetStatusTag("MonitorEventN", std::to_string(float(m_evt_c/m_fraction)));
+    std::unique_lock<std::mutex> lk(m_mtx_sender);
+    auto senders = m_senders;
+    lk.unlock();
+    if(senders){
+      uint64_t mn_sent = 0;
+      for(auto &mn: *senders){
+	mn_sent += mn.sender->GetSentN();
+	SetStatusTag("MonitorSent_" + mn.name, std::to_string(mn.sender->GetSentN()));
+	SetStatusTag("MonitorDropped_" + mn.name, std::to_string(mn.sender->GetDroppedN()));
+	SetStatusTag("MonitorQueued_" + mn.name, std::to_string(mn.sender->GetQueuedN()));
+      }
+      SetStatusTag("MonitorEventN", std::to_string(mn_sent));
+    }
+    for(auto &e: GetQueueStatus())
+      SetStatusTag(e.first, e.second);
     DoStatus();
     // if(m_writer && m_writer->FileBytes()){
     //   SetStatusTag("FILEBYTES", std::to_string(m_writer->FileBytes()));
@@ -182,20 +229,27 @@ namespace eudaq {
   void DataCollector::OnReceive(ConnectionSPC id, EventSP ev){
     DoReceive(id, ev);
   }  
+
+  void DataCollector::OnReceiveEvents(ConnectionSPC id, std::vector<EventSP> &evs){
+    DoReceiveEvents(id, evs);
+  }
+
+  void DataCollector::StampEvent(Event &ev){
+    if(ev.IsBORE()){
+      if(GetConfiguration())
+	ev.SetTag("EUDAQ_CONFIG", to_string(*GetConfiguration()));
+      if(GetInitConfiguration())
+	ev.SetTag("EUDAQ_CONFIG_INIT", to_string(*GetInitConfiguration()));
+    }
+    ev.SetRunN(GetRunNumber());
+    ev.SetEventN(m_evt_c);
+    m_evt_c ++;
+    ev.SetStreamN(m_dct_n);
+  }
     
   void DataCollector::WriteEvent(EventSP ev){
     try{
-      if(ev->IsBORE()){
-	if(GetConfiguration())
-	  ev->SetTag("EUDAQ_CONFIG", to_string(*GetConfiguration()));
-	if(GetInitConfiguration())
-	  ev->SetTag("EUDAQ_CONFIG_INIT", to_string(*GetInitConfiguration()));
-      }
-      
-      ev->SetRunN(GetRunNumber());
-      ev->SetEventN(m_evt_c);
-      m_evt_c ++;
-      ev->SetStreamN(m_dct_n);
+      StampEvent(*ev);
       auto file_writer = m_writer;
       if(file_writer)
 	file_writer->WriteEvent(ev);
@@ -204,14 +258,45 @@ namespace eudaq {
       std::unique_lock<std::mutex> lk(m_mtx_sender);
       auto senders = m_senders;
       lk.unlock();
-      if(m_evt_c%m_fraction != 0){
+      if(!senders)
 	return;
+      for(auto &mn: *senders){
+	if(mn.fraction && m_evt_c%mn.fraction == 0)
+	  mn.sender->SendEvent(ev);
+      }
+    }catch (const Exception &e) {
+      std::string msg = "Exception writing to file: ";
+      msg += e.what();
+      EUDAQ_ERROR(msg);
+      SetStatus(Status::STATE_ERROR, msg);
+    }
+  }
+
+  void DataCollector::WriteEvents(std::vector<EventSP> &evs){
+    try{
+      std::vector<EventSPC> out;
+      out.reserve(evs.size());
+      for(auto &ev: evs){
+	StampEvent(*ev);
+	out.push_back(std::move(ev));
       }
-      for(auto &e: senders){
-	if(e.second)
-	  e.second->SendEvent(ev);
-	else
-	  EUDAQ_THROW("DataCollector::WriterEvent, using a null pointer of DataSender");
+      evs.clear();
+      auto file_writer = m_writer;
+      if(file_writer)
+	file_writer->WriteEvents(out);
+      else
+	EUDAQ_THROW("FileWriter is not created before writing.");
+      std::unique_lock<std::mutex> lk(m_mtx_sender);
+      auto senders = m_senders;
+      lk.unlock();
+      if(!senders)
+	return;
+      for(auto &ev: out){
+	uint32_t evt_c = ev->GetEventN() + 1; // m_evt_c after the event
+	for(auto &mn: *senders){
+	  if(mn.fraction && evt_c%mn.fraction == 0)
+	    mn.sender->SendEvent(ev);
+	}
       }
     }catch (const Exception &e) {
       std::string msg = "Exception writing to file: ";
@@ -1,16 +1,58 @@
 #include "eudaq/DataReceiver.hh"
 #include "eudaq/TransportServer.hh"
-#include "eudaq/BufferSerializer.hh"
+#include "eudaq/StringDeserializer.hh"
 #include "eudaq/Logger.hh"
 #include "eudaq/Utils.hh"
 #include <iostream>
 #include <ostream>
 #include <ctime>
 #include <iomanip>
+#include <fstream>
+#include <cstdio>
+#include <algorithm>
+#include <deque>
 namespace eudaq {
+
+  struct DataReceiver::Flow{
+    Flow(const std::string &n)
+      :name(n), bytes(0), events(0), dropped(0), spilled(0), paused(false),
+       dropping(false), spilling(false), closed(false), spill_rd(0), spill_wr(0){}
+    ~Flow(){
+      if(spill.is_open()){
+	spill.close();
+	std::remove(spill_path.c_str());
+      }
+    }
+    std::string name;
+    std::atomic<uint64_t> bytes; // received, but not yet handled
+    std::atomic<uint64_t> events;
+    std::atomic<uint64_t> dropped;
+    std::atomic<uint64_t> spilled;
+    std::atomic<bool> paused;
+    bool dropping;
+    std::mutex mtx; // guards pausing, the held events and the spill file
+    std::deque<Item> held; // waiting for room in the queue, without the flow
+    std::atomic<bool> spilling;
+    bool closed; // disconnected while data was still spilled
+    std::fstream spill;
+    std::string spill_path;
+    uint64_t spill_rd;
+    uint64_t spill_wr;
+  };
+
+  struct DataReceiver::Packet{
+    Packet(std::string &&d):data(std::move(d)), state(0){}
+    std::string data;
+    EventSP ev;
+    std::string error;
+    std::atomic<int> state; // 0: waiting, 1: being decoded, 2: decoded
+  };
   
   DataReceiver::DataReceiver()
-    :m_is_listening(false),m_is_destructing(false), m_last_addr("tcp://0"){
+    :m_is_listening(false),m_is_destructing(false), m_last_addr("tcp://0"),
+     m_qu_ev(65536), m_flow_mode(FLOW_BLOCK), m_flow_bytes(uint64_t(256) << 20),
+     m_spill_active(0), m_held_active(0), m_qu_dec(4096), m_dec_wait(false){
+    SetDecodeThreads(-1);
   }
 
   DataReceiver::~DataReceiver(){
@@ -28,7 +70,325 @@ namespace eudaq {
   
   void DataReceiver::OnReceive(ConnectionSPC id, EventSP ev){
   }
+
+  void DataReceiver::OnReceiveEvents(ConnectionSPC id, std::vector<EventSP> &evs){
+    for(auto &ev: evs)
+      OnReceive(id, ev);
+  }
   
+  void DataReceiver::SetFlowControl(const std::string &mode, uint64_t max_bytes,
+				    const std::string &spill_dir){
+    switch(str2hash(mode)){
+    case cstr2hash("drop"):
+      m_flow_mode = FLOW_DROP;
+      break;
+    case cstr2hash("block"):
+      m_flow_mode = FLOW_BLOCK;
+      break;
+    case cstr2hash("spill"):
+      m_flow_mode = FLOW_SPILL;
+      break;
+    default:
+      EUDAQ_THROW("DataReceiver: Unknown flow control mode \"" + mode + "\"");
+    }
+    m_flow_bytes = max_bytes ? max_bytes : 1;
+    m_spill_dir = spill_dir;
+  }
+
+  std::map<std::string, std::string> DataReceiver::GetQueueStatus() const{
+    std::map<std::string, std::string> tags;
+    tags["QueueEvents"] = std::to_string(m_qu_ev.Size());
+    std::unique_lock<std::mutex> lk(m_mx_flow);
+    for(auto &e: m_flows){
+      auto &flow = *e.second.second;
+      std::string val = std::to_string(flow.events) + " events, "
+	+ std::to_string(flow.bytes) + " bytes";
+      if(flow.paused)
+	val += ", paused";
+      if(flow.dropped)
+	val += ", " + std::to_string(flow.dropped) + " dropped";
+      if(flow.spilled)
+	val += ", " + std::to_string(flow.spilled) + " spilled";
+      tags["Queue." + flow.name] = val;
+    }
+    return tags;
+  }
+
+  void DataReceiver::SetDecodeThreads(int n){
+    if(n < 0){
+      uint32_t hw = std::thread::hardware_concurrency();
+      m_dec_n = hw > 1 ? std::min<uint32_t>(hw - 1, 4) : 0;
+    }
+    else
+      m_dec_n = n;
+  }
+
+  void DataReceiver::Decode(Packet &pkt){
+    int st = 0;
+    if(!pkt.state.compare_exchange_strong(st, 1))
+      return;
+    try{
+      // the payload is taken over, the blocks of the event refer to it
+      StringDeserializer ser(std::move(pkt.data));
+      uint32_t id;
+      ser.PreRead(id);
+      pkt.ev = Factory<Event>::MakeUnique<Deserializer&>(id, ser);
+      if(!pkt.ev)
+	pkt.error = "unknown event type " + std::to_string(id);
+    }
+    catch(const std::exception &e){
+      pkt.error = e.what();
+    }
+    catch(...){
+      pkt.error = "unknown exception";
+    }
+    std::string().swap(pkt.data);
+    pkt.state = 2;
+    if(m_dec_wait){
+      std::lock_guard<std::mutex> lk(m_mx_dec);
+      m_cv_dec.notify_all();
+    }
+  }
+
+  EventSP DataReceiver::Decoded(Packet &pkt){
+    // packets nobody has started on yet are decoded right here
+    Decode(pkt);
+    if(pkt.state != 2){
+      m_dec_wait = true;
+      std::unique_lock<std::mutex> lk(m_mx_dec);
+      m_cv_dec.wait(lk, [&pkt]{return pkt.state == 2;});
+      lk.unlock();
+      m_dec_wait = false;
+    }
+    return std::move(pkt.ev);
+  }
+
+  void DataReceiver::Dispatch(std::shared_ptr<Packet> pkt){
+    // without a free slot the packet is decoded by the forwarding thread
+    if(!m_th_dec.empty())
+      m_qu_dec.TryPush(std::move(pkt));
+  }
+
+  void DataReceiver::AsyncDecoding(){
+    std::shared_ptr<Packet> pkt;
+    for(;;){
+      if(!m_qu_dec.Pop(pkt, std::chrono::seconds(1))){
+	if(m_qu_dec.IsClosed())
+	  return;
+	continue;
+      }
+      Decode(*pkt);
+      pkt.reset();
+    }
+  }
+
+  void DataReceiver::Receive(ConnectionSPC con, std::string &&packet){
+    std::unique_lock<std::mutex> lk(m_mx_flow);
+    auto it = m_flows.find(con.get());
+    if(it == m_flows.end())
+      EUDAQ_THROW("DataReceiver: Unrecognised Connection"  + to_string(*con));
+    auto flow = it->second.second;
+    lk.unlock();
+    uint64_t n = packet.size();
+    auto pkt = std::make_shared<Packet>(std::move(packet));
+    uint64_t queued = flow->bytes;
+    bool over = queued && queued + n > m_flow_bytes;
+    switch(m_flow_mode){
+    case FLOW_DROP:
+      if(!over){
+	flow->bytes += n;
+	flow->events++;
+	if(m_qu_ev.TryPush(Item{pkt, con, flow, n})){
+	  Dispatch(pkt);
+	  if(flow->dropping && flow->bytes <= m_flow_bytes / 2)
+	    flow->dropping = false;
+	  return;
+	}
+	flow->bytes -= n;
+	flow->events--;
+      }
+      flow->dropped++;
+      if(!flow->dropping){
+	flow->dropping = true;
+	EUDAQ_WARN("DataReceiver: Buffer of " + flow->name + " is full, dropping events");
+      }
+      return;
+    case FLOW_BLOCK:{
+      flow->bytes += n;
+      flow->events++;
+      std::unique_lock<std::mutex> lk_flow(flow->mtx);
+      // with the shared queue full only this connection stops reading, its
+      // events wait in order until PushHeld() finds room for them
+      if(!flow->held.empty() || !m_qu_ev.TryPush(Item{pkt, con, flow, n})){
+	if(flow->held.empty())
+	  m_held_active++;
+	flow->held.push_back(Item{pkt, con, nullptr, n});
+	if(!flow->paused){
+	  flow->paused = true;
+	  m_dataserver->PauseReceive(*con, true);
+	}
+	return;
+      }
+      lk_flow.unlock();
+      Dispatch(pkt);
+      if(flow->bytes > m_flow_bytes && !flow->paused){
+	// see Release() for the other half of this handshake
+	std::unique_lock<std::mutex> lk_flow(flow->mtx);
+	flow->paused = true;
+	if(flow->bytes > m_flow_bytes)
+	  m_dataserver->PauseReceive(*con, true);
+	else
+	  flow->paused = false;
+      }
+      return;
+    }
+    case FLOW_SPILL:{
+      std::unique_lock<std::mutex> lk_flow(flow->mtx);
+      if(!flow->spilling && !over){
+	flow->bytes += n;
+	flow->events++;
+	if(m_qu_ev.TryPush(Item{pkt, con, flow, n})){
+	  Dispatch(pkt);
+	  return;
+	}
+	flow->bytes -= n;
+	flow->events--;
+      }
+      // once spilling, everything goes through the file to keep the order
+      if(!flow->spill.is_open()){
+	flow->spill_path = (m_spill_dir.empty() ? std::string(".") : m_spill_dir)
+	  + "/eudaq_spill_" + flow->name + "_"
+	  + std::to_string(reinterpret_cast<uintptr_t>(flow.get())) + ".tmp";
+	flow->spill.open(flow->spill_path, std::ios::in | std::ios::out |
+			 std::ios::binary | std::ios::trunc);
+	if(!flow->spill.is_open())
+	  EUDAQ_THROW("DataReceiver: Unable to open spill file " + flow->spill_path);
+      }
+      uint64_t len = n;
+      flow->spill.seekp(flow->spill_wr);
+      flow->spill.write(reinterpret_cast<const char*>(&len), sizeof(len));
+      flow->spill.write(pkt->data.data(), n);
+      if(!flow->spill)
+	EUDAQ_THROW("DataReceiver: Unable to write spill file " + flow->spill_path);
+      flow->spill_wr += sizeof(len) + n;
+      flow->spilled++;
+      if(!flow->spilling){
+	flow->spilling = true;
+	m_spill_active++;
+	EUDAQ_WARN("DataReceiver: Buffer of " + flow->name + " is full, spilling to "
+		   + flow->spill_path);
+      }
+      return;
+    }
+    }
+  }
+
+  void DataReceiver::Release(const Item &item){
+    auto &flow = *item.flow;
+    flow.bytes -= item.bytes;
+    flow.events--;
+    if(flow.paused && flow.bytes <= m_flow_bytes / 2){
+      std::unique_lock<std::mutex> lk(flow.mtx);
+      if(flow.paused && flow.held.empty() && flow.bytes <= m_flow_bytes / 2){
+	flow.paused = false;
+	m_dataserver->PauseReceive(*item.con, false);
+      }
+    }
+  }
+
+  void DataReceiver::Reload(ConnectionSPC con, std::shared_ptr<Flow> flow){
+    // spilled data is appended behind the queued events of the connection,
+    // and only pushed into the queue, so this thread never waits on itself
+    std::unique_lock<std::mutex> lk(flow->mtx);
+    while(flow->spilling && flow->bytes <= m_flow_bytes / 2){
+      if(flow->spill_rd == flow->spill_wr){
+	if(flow->closed && !m_qu_ev.TryPush(Item{nullptr, con, nullptr, 0}))
+	  return;
+	flow->spill_rd = flow->spill_wr = 0;
+	flow->spilling = false;
+	m_spill_active--;
+	if(flow->closed){
+	  lk.unlock();
+	  std::unique_lock<std::mutex> lk_flows(m_mx_flow);
+	  m_flows.erase(con.get());
+	}
+	return;
+      }
+      uint64_t len = 0;
+      flow->spill.seekg(flow->spill_rd);
+      flow->spill.read(reinterpret_cast<char*>(&len), sizeof(len));
+      std::string packet(len, '\0');
+      flow->spill.read(&packet[0], len);
+      if(!flow->spill)
+	EUDAQ_THROW("DataReceiver: Unable to read spill file " + flow->spill_path);
+      flow->bytes += len;
+      flow->events++;
+      auto pkt = std::make_shared<Packet>(std::move(packet));
+      if(!m_qu_ev.TryPush(Item{pkt, con, flow, len})){
+	flow->bytes -= len;
+	flow->events--;
+	return;
+      }
+      Dispatch(pkt);
+      flow->spill_rd += sizeof(len) + len;
+    }
+  }
+
+  void DataReceiver::PushHeld(){
+    if(!m_held_active)
+      return;
+    std::vector<std::pair<ConnectionSPC, std::shared_ptr<Flow>>> flows;
+    std::unique_lock<std::mutex> lk(m_mx_flow);
+    for(auto &e: m_flows)
+      flows.push_back(e.second);
+    lk.unlock();
+    for(auto &e: flows){
+      auto &con = e.first;
+      auto &flow = e.second;
+      std::unique_lock<std::mutex> lk_flow(flow->mtx);
+      if(flow->held.empty())
+	continue;
+      while(!flow->held.empty()){
+	Item &item = flow->held.front();
+	auto pkt = item.pkt;
+	if(pkt)
+	  item.flow = flow;
+	// the item is only moved from if it was pushed
+	if(!m_qu_ev.TryPush(std::move(item))){
+	  item.flow.reset();
+	  return;
+	}
+	flow->held.pop_front();
+	if(pkt)
+	  Dispatch(pkt);
+      }
+      m_held_active--;
+      if(flow->closed){
+	lk_flow.unlock();
+	lk.lock();
+	m_flows.erase(con.get());
+	lk.unlock();
+      }
+      else if(flow->paused && flow->bytes <= m_flow_bytes / 2){
+	flow->paused = false;
+	m_dataserver->PauseReceive(*con, false);
+      }
+    }
+  }
+
+  void DataReceiver::ReloadSpills(){
+    if(!m_spill_active)
+      return;
+    std::vector<std::pair<ConnectionSPC, std::shared_ptr<Flow>>> flows;
+    std::unique_lock<std::mutex> lk(m_mx_flow);
+    for(auto &e: m_flows)
+      if(e.second.second->spilling)
+	flows.push_back(e.second);
+    lk.unlock();
+    for(auto &e: flows)
+      Reload(e.first, e.second);
+  }
+
   void DataReceiver::DataHandler(TransportEvent &ev) {
     auto con = ev.id;
     bool has_con_for_discon = false;
@@ -42,9 +402,32 @@ namespace eudaq {
       for (size_t i = 0; i < m_vt_con.size(); ++i){
 	if (m_vt_con[i] == con){
 	  m_vt_con.erase(m_vt_con.begin() + i);
-	  std::unique_lock<std::mutex> lk(m_mx_qu_ev);
-	  m_qu_ev.push(std::make_pair<EventSP, ConnectionSPC>(nullptr, con));
-	  m_cv_not_empty.notify_all();
+	  std::unique_lock<std::mutex> lk(m_mx_flow);
+	  auto it = m_flows.find(con.get());
+	  auto flow = it != m_flows.end() ? it->second.second : nullptr;
+	  lk.unlock();
+	  bool later = false;
+	  if(flow){
+	    std::unique_lock<std::mutex> lk_flow(flow->mtx);
+	    flow->closed = true;
+	    // the disconnection follows the spilled data, see Reload(), or
+	    // the held events, see PushHeld()
+	    if(flow->spilling)
+	      later = true;
+	    else if(!flow->held.empty() || !m_qu_ev.TryPush(Item{nullptr, con, nullptr, 0})){
+	      if(flow->held.empty())
+		m_held_active++;
+	      flow->held.push_back(Item{nullptr, con, nullptr, 0});
+	      later = true;
+	    }
+	  }
+	  else
+	    m_qu_ev.Push(Item{nullptr, con, nullptr, 0});
+	  if(!later){
+	    lk.lock();
+	    m_flows.erase(con.get());
+	    lk.unlock();
+	  }
 	  has_con_for_discon = true;
 	}
       }
@@ -87,23 +470,14 @@ namespace eudaq {
         con->SetState(1); // successfully identified
 	EUDAQ_INFO("DataReceiver: Connection from " + to_string(*con));
 	m_vt_con.push_back(con);
-	std::unique_lock<std::mutex> lk(m_mx_qu_ev);
-	m_qu_ev.push(std::make_pair<EventSP, ConnectionSPC>(nullptr, con));
-	m_cv_not_empty.notify_all();
+	std::unique_lock<std::mutex> lk(m_mx_flow);
+	m_flows[con.get()] = std::make_pair(con, std::make_shared<Flow>
+					    (con->GetType() + "." + con->GetName()));
+	lk.unlock();
+	m_qu_ev.Push(Item{nullptr, con, nullptr, 0});
       }
       else{ //identified connection  
-	BufferSerializer ser(ev.packet.begin(), ev.packet.end());
-	uint32_t id;
-	ser.PreRead(id);
-	auto ev_con = std::make_pair<EventSP, ConnectionSPC>
-	  (Factory<Event>::MakeUnique<Deserializer&>(id, ser), con);
-	std::unique_lock<std::mutex> lk(m_mx_qu_ev);
-	m_qu_ev.push(ev_con);
-	if(m_qu_ev.size() > 50000){
-	  m_qu_ev.pop();
-	  EUDAQ_WARN("DataReceiver: Buffer of receving event is full.");
-	}
-	m_cv_not_empty.notify_all();
+	Receive(con, std::move(ev.packet));
       }
       break;
     default:
@@ -121,34 +495,58 @@ namespace eudaq {
   }
 
   bool DataReceiver::AsyncForwarding(){
+    Item item;
+    // events already waiting in the queue are handed over as one batch
+    std::vector<EventSP> batch;
+    ConnectionSPC batch_con;
+    auto flush = [&](){
+      if(!batch.empty())
+	OnReceiveEvents(batch_con, batch);
+      batch.clear();
+      batch_con.reset();
+    };
     while(!m_is_async_rcv_return){
-      std::unique_lock<std::mutex> lk(m_mx_qu_ev);
-      while(m_qu_ev.empty()){
-	while(m_cv_not_empty.wait_for(lk, std::chrono::seconds(1))
-	      ==std::cv_status::timeout){
-	  if(m_is_async_rcv_return){
-	    for(auto &con: m_vt_con){
-	      OnDisconnect(con);
-	    }
-	    m_vt_con.clear();
-	    return 0;
+      PushHeld();
+      ReloadSpills();
+      if(!m_qu_ev.Pop(item, std::chrono::seconds(1))){
+	if(m_is_async_rcv_return){
+	  for(auto &con: m_vt_con){
+	    OnDisconnect(con);
 	  }
+	  m_vt_con.clear();
+	  return 0;
 	}
+	continue;
       }
-      auto ev = m_qu_ev.front().first;
-      auto con = m_qu_ev.front().second;
-      m_qu_ev.pop();
-      lk.unlock();
-      if(ev){
-	OnReceive(con, ev);
-      }
-      else{
-	if(con->GetState())
-	  OnConnect(con);
+      do{
+	if(item.flow){
+	  Release(item);
+	  item.flow.reset();
+	}
+	auto pkt = std::move(item.pkt);
+	auto con = std::move(item.con);
+	if(pkt){
+	  auto ev = Decoded(*pkt);
+	  if(ev){
+	    if(con != batch_con)
+	      flush();
+	    batch_con = con;
+	    batch.push_back(std::move(ev));
+	  }
+	  else
+	    EUDAQ_ERROR("DataReceiver: Unable to decode data from " + to_string(*con)
+			+ ": " + pkt->error);
+	}
 	else{
-	  OnDisconnect(con);
+	  flush();
+	  if(con->GetState())
+	    OnConnect(con);
+	  else{
+	    OnDisconnect(con);
+	  }
 	}
-      }
+      }while(batch.size() < 256 && m_qu_ev.TryPop(item));
+      flush();
     }
     //clear remaining connections
     for(auto &con: m_vt_con){
@@ -179,6 +577,8 @@ namespace eudaq {
     m_dataserver.reset(dataserver);
     m_is_listening = true;
     m_is_async_rcv_return = false;
+    for(uint32_t i = 0; i < m_dec_n; i++)
+      m_th_dec.emplace_back(&DataReceiver::AsyncDecoding, this);
     m_fut_async_rcv = std::async(std::launch::async, &DataReceiver::AsyncReceiving, this); 
     m_fut_async_fwd = std::async(std::launch::async, &DataReceiver::AsyncForwarding, this);
     return m_last_addr;
@@ -223,10 +623,25 @@ namespace eudaq {
 	  if(m_fut_async_fwd.valid()){
 	    m_fut_async_fwd.get();
 	  }
-	  if(!m_qu_ev.empty()){
+	  if(!m_qu_ev.Empty()){
 	    EUDAQ_WARN("DataReceiver: Data buffer is not empty during the stopping");
-	    m_qu_ev = std::queue<std::pair<EventSP, ConnectionSPC>>();
+	    m_qu_ev.Clear();
 	  }
+	  if(m_spill_active)
+	    EUDAQ_WARN("DataReceiver: Spilled data is discarded during the stopping");
+	  if(m_held_active)
+	    EUDAQ_WARN("DataReceiver: Held data is discarded during the stopping");
+	  m_qu_dec.Close();
+	  for(auto &th: m_th_dec)
+	    th.join();
+	  m_th_dec.clear();
+	  m_qu_dec.Clear();
+	  m_qu_dec.Open();
+	  std::unique_lock<std::mutex> lk_flow(m_mx_flow);
+	  m_flows.clear();
+	  m_spill_active = 0;
+	  m_held_active = 0;
+	  lk_flow.unlock();
 	  if(m_dataserver)
 	    m_dataserver.reset();
 	}
@@ -244,10 +659,25 @@ namespace eudaq {
       if(m_fut_async_fwd.valid()){
 	m_fut_async_fwd.get();
       }
-      if(!m_qu_ev.empty()){
+      if(!m_qu_ev.Empty()){
 	EUDAQ_WARN("DataReceiver: Data buffer is not empty during the exiting");
-	m_qu_ev = std::queue<std::pair<EventSP, ConnectionSPC>>();
+	m_qu_ev.Clear();
       }
+      if(m_spill_active)
+	EUDAQ_WARN("DataReceiver: Spilled data is discarded during the exiting");
+      if(m_held_active)
+	EUDAQ_WARN("DataReceiver: Held data is discarded during the exiting");
+      m_qu_dec.Close();
+      for(auto &th: m_th_dec)
+        th.join();
+      m_th_dec.clear();
+      m_qu_dec.Clear();
+      m_qu_dec.Open();
+      std::unique_lock<std::mutex> lk_flow(m_mx_flow);
+      m_flows.clear();
+      m_spill_active = 0;
+      m_held_active = 0;
+      lk_flow.unlock();
       if(m_dataserver)
 	m_dataserver.reset();
     }
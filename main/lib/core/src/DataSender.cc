@@ -1,7 +1,7 @@
 #include "eudaq/Event.hh"
 #include "eudaq/TransportClient.hh"
 #include "eudaq/Exception.hh"
-#include "eudaq/BufferSerializer.hh"
+#include "eudaq/GatherSerializer.hh"
 #include "eudaq/Logger.hh"
 #include "eudaq/DataSender.hh"
 
@@ -10,33 +10,59 @@ namespace eudaq {
   DataSender::DataSender(const std::string & type, const std::string & name)
     : m_type(type),
     m_name(name),
-    m_packetCounter(0) {}
+    m_packetCounter(0), m_n_dropped(0), m_is_connected(false),
+    m_drop_oldest(true), m_drain(1000) {}
 
 
   DataSender::~DataSender(){
     std::cout<<"dataSender clearing"<<std::endl;
-    m_is_connected = false;
-    if(m_fut_async.valid()){
-      m_fut_async.get();
+    try{
+      StopSending();
+    }
+    catch(...){
     }
     std::cout<< "dataSender cleared"<<std::endl;
   }
+
+  void DataSender::SetQueue(size_t depth, const std::string &drop,
+			    uint32_t drain_ms){
+    if(m_is_connected)
+      EUDAQ_THROW("DataSender:: The queue is set before connecting");
+    if(drop == "oldest")
+      m_drop_oldest = true;
+    else if(drop == "newest")
+      m_drop_oldest = false;
+    else
+      EUDAQ_THROW("DataSender:: Unknown drop policy '" + drop + "'");
+    m_drain = std::chrono::milliseconds(drain_ms);
+    if(depth)
+      m_qu_ev.reset(new LockFreeQueue<EventSPC>(depth));
+    else
+      m_qu_ev.reset();
+  }
   
-  void DataSender::Connect(const std::string & server) {
+  void DataSender::StopSending(){
+    // the sending thread empties the queue, the EORE included, until
+    // m_drain_end, which is set before it sees m_is_connected cleared
+    m_drain_end = std::chrono::steady_clock::now() + m_drain;
     m_is_connected = false;
+    if(m_fut_async.valid())
+      m_fut_async.get();
+    if(m_qu_ev){
+      m_n_dropped += m_qu_ev->Size();
+      m_qu_ev->Clear();
+    }
+  }
+
+  void DataSender::Connect(const std::string & server) {
     try{
-      if(m_fut_async.valid()){
-	m_fut_async.get();
-	//previous connection is closed.
-      }
+      StopSending();
+      //previous connection is closed.
     }
     catch(...){
       EUDAQ_WARN("DataSender:: connection execption from disconnetion");
     }
     
-    std::unique_lock<std::mutex> lk(m_mx_qu_ev);    
-    m_qu_ev = std::queue<EventSPC>();    
-    lk.unlock();
     m_dataclient.reset(TransportClient::CreateClient(server));
     std::string packet;
     if (!m_dataclient->ReceivePacket(&packet, 1000000))
@@ -75,51 +101,76 @@ namespace eudaq {
     if (std::string(packet, 0, i1) != "OK")
       EUDAQ_THROW("DataSender:: Connection refused by DataReceiver server: " + packet);
     m_is_connected = true;
-    m_fut_async = std::async(std::launch::async, &DataSender::AsyncSending, this);
+    if(m_qu_ev)
+      m_fut_async = std::async(std::launch::async, &DataSender::AsyncSending, this);
   }
 
   void DataSender::SendEvent(EventSPC ev){
+    if(m_qu_ev){
+      // never waits for the receiver, a full queue loses an event
+      if(!m_is_connected){
+	Drop();
+	return;
+      }
+      if(m_qu_ev->TryPush(ev))
+	return;
+      if(m_drop_oldest){
+	EventSPC old;
+	bool popped = m_qu_ev->TryPop(old);
+	if(popped && m_qu_ev->TryPush(ev)){
+	  Drop();
+	  return;
+	}
+	if(popped)
+	  Drop();
+      }
+      Drop();
+      return;
+    }
     if (!m_dataclient)
       EUDAQ_THROW("DataSender:: Transport not connected error");
 
-    /*
-    std::unique_lock<std::mutex> lk(m_mx_qu_ev);
-    m_qu_ev.push(ev);
-    if(m_qu_ev.size() > 50000){
-      m_qu_ev.pop();
-      EUDAQ_WARN("DataSender:: Buffer of sending event is full.");
-    }    
-    m_cv_not_empty.notify_all();
-    */
-
-    BufferSerializer ser;
+    // the data blocks are sent from the event itself, which is alive here
+    GatherSerializer ser;
     ev->Serialize(ser);
     m_packetCounter += 1;
     //TODO: catch exception below
-    m_dataclient->SendPacket(ser);
+    m_dataclient->SendPacketParts(ser.Parts());
+  }
+
+  void DataSender::Drop(){
+    if(m_n_dropped.fetch_add(1) == 0)
+      EUDAQ_WARN("DataSender:: " + m_name + " is discarding events, the receiver does not keep up");
   }
 
   bool DataSender::AsyncSending(){
-    while(m_is_connected){//TODO:
-      std::unique_lock<std::mutex> lk(m_mx_qu_ev);
-      while(m_qu_ev.empty()){
-	while(m_cv_not_empty.wait_for(lk, std::chrono::milliseconds(100))
-	      ==std::cv_status::timeout){
-	  if(!m_is_connected){
-	    return 0;
-	  }
-	}
+    while(true){
+      bool stopping = !m_is_connected;
+      EventSPC ev;
+      if(!m_qu_ev->Pop(ev, std::chrono::milliseconds(stopping ?0 :100))){
+	if(stopping)
+	  break;
+	continue;
+      }
+      if(stopping && std::chrono::steady_clock::now() > m_drain_end){
+	EUDAQ_WARN("DataSender:: " + m_name + " could not send its queue before stopping");
+	Drop();
+	break;
+      }
+      try{
+	GatherSerializer ser;
+	ev->Serialize(ser);
+	m_dataclient->SendPacketParts(ser.Parts());
+	m_packetCounter += 1;
+      }catch(const std::exception &e){
+	EUDAQ_ERROR(std::string("DataSender:: Sending failed, no further events are sent: ") + e.what());
+	m_is_connected = false;
+	m_n_dropped += 1 + m_qu_ev->Size();
+	m_qu_ev->Clear();
+	return false;
       }
-      auto ev = m_qu_ev.front();
-      m_qu_ev.pop();
-      lk.unlock();
-      BufferSerializer ser;
-      ev->Serialize(ser);
-      m_packetCounter += 1;
-      //TODO: catch exception below
-      m_dataclient->SendPacket(ser);
     }
-    
+    return true;
   }
   
 }
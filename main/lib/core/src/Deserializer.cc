@@ -1,8 +1,10 @@
 #include "eudaq/Deserializer.hh"
+#include "eudaq/DataBlock.hh"
 
 namespace eudaq{
   Deserializer::Deserializer()
-    :m_interrupting(false){
+    :m_interrupting(false), m_rd_buf(nullptr), m_rd_data(nullptr),
+     m_rd_size(0), m_rd_pos(0){
   }
   Deserializer::~Deserializer(){
   }
@@ -11,8 +13,15 @@ namespace eudaq{
     m_interrupting = true;
   }
 
-  void Deserializer::read(unsigned char *dst, size_t size){
-    Deserialize(dst, size);
+  DataBlock Deserializer::ReadBlock(size_t size){
+    return DeserializeBlock(size);
+  }
+
+  DataBlock Deserializer::DeserializeBlock(size_t size){
+    std::vector<uint8_t> buf(size);
+    if(size)
+      read(&buf[0], size);
+    return DataBlock(std::move(buf));
   }
 
   void Deserializer::PreRead(uint32_t &t){
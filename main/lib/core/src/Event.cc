@@ -105,13 +105,37 @@ namespace eudaq {
   }
 
   std::vector<uint8_t> Event::GetBlock(uint32_t i) const{
+    return GetDataBlock(i).ToVector();
+  }
+
+  BlockView Event::GetBlockView(uint32_t i) const{
+    auto it = m_blocks.find(i);
+    if(it == m_blocks.end()){
+      EUDAQ_WARN(std::string("RAWDATAEVENT:: no bolck with ID ") + std::to_string(i) + " exists");
+      return BlockView();
+    }
+    return it->second.View();
+  }
+
+  DataBlock Event::GetDataBlock(uint32_t i) const{
     auto it = m_blocks.find(i);
     if(it == m_blocks.end()){
       EUDAQ_WARN(std::string("RAWDATAEVENT:: no bolck with ID ") + std::to_string(i) + " exists");
+      return DataBlock();
     }
     return it->second;
   }
 
+  size_t Event::AddBlock(uint32_t id, std::vector<uint8_t> &&data){
+    m_blocks[id] = DataBlock(std::move(data));
+    return m_blocks.size();
+  }
+
+  size_t Event::AddBlock(uint32_t id, DataBlock data){
+    m_blocks[id] = std::move(data);
+    return m_blocks.size();
+  }
+
   std::vector<uint32_t> Event::GetBlockNumList() const {
     std::vector<uint32_t> vnum;
     for(auto &e : m_blocks){
@@ -0,0 +1,212 @@
+#include "eudaq/EventBuilder.hh"
+#include "eudaq/Exception.hh"
+#include "eudaq/Utils.hh"
+
+#include <algorithm>
+
+namespace eudaq {
+
+  EventBuilder::EventBuilder()
+    :m_n_streams(0), m_n_active(0), m_n_empty(0), m_n_over(0), m_n_pending(0),
+     m_has_last(false), m_last_key(0), m_policy(MISSING_WAIT), m_timeout(0),
+     m_max_queue(0), m_n_built(0), m_n_incomplete(0), m_n_dropped(0), m_n_late(0){
+  }
+
+  EventBuilder::MissingPolicy EventBuilder::ParsePolicy(const std::string &policy){
+    switch(str2hash(policy)){
+    case cstr2hash("wait"):
+      return MISSING_WAIT;
+    case cstr2hash("partial"):
+      return MISSING_PARTIAL;
+    case cstr2hash("drop"):
+      return MISSING_DROP;
+    default:
+      EUDAQ_THROW("EventBuilder: Unknown missing fragment policy \"" + policy + "\"");
+    }
+  }
+
+  void EventBuilder::Configure(MissingPolicy policy, uint32_t timeout_ms, size_t max_queue){
+    m_policy = policy;
+    m_timeout = std::chrono::milliseconds(timeout_ms);
+    m_max_queue = max_queue;
+    m_n_over = 0;
+    if(m_max_queue)
+      for(auto &s: m_streams)
+	if(s.used && s.que.size() > m_max_queue)
+	  m_n_over++;
+  }
+
+  uint32_t EventBuilder::AddStream(const std::string &name){
+    uint32_t id;
+    if(m_free.empty()){
+      id = m_streams.size();
+      m_streams.emplace_back();
+    }
+    else{
+      id = m_free.back();
+      m_free.pop_back();
+    }
+    auto &s = m_streams[id];
+    s.name = name;
+    s.used = true;
+    s.active = true;
+    m_n_streams++;
+    m_n_active++;
+    m_n_empty++;
+    return id;
+  }
+
+  void EventBuilder::RemoveStream(uint32_t id, bool drain){
+    if(id >= m_streams.size() || !m_streams[id].used || !m_streams[id].active)
+      return;
+    auto &s = m_streams[id];
+    if(!drain || s.que.empty()){
+      Erase(id);
+      return;
+    }
+    s.active = false;
+    m_n_active--;
+  }
+
+  size_t EventBuilder::GetPendingN(uint32_t id) const{
+    if(id >= m_streams.size() || !m_streams[id].used)
+      return 0;
+    return m_streams[id].que.size();
+  }
+
+  void EventBuilder::Erase(uint32_t id){
+    auto &s = m_streams[id];
+    if(s.active){
+      m_n_active--;
+      if(s.que.empty())
+	m_n_empty--;
+    }
+    bool queued = !s.que.empty();
+    if(m_max_queue && s.que.size() > m_max_queue)
+      m_n_over--;
+    m_n_pending -= s.que.size();
+    s.que.clear();
+    s.used = false;
+    s.name.clear();
+    m_free.push_back(id);
+    m_n_streams--;
+    if(queued)
+      RebuildHeap();
+  }
+
+  void EventBuilder::RebuildHeap(){
+    m_heap.clear();
+    for(uint32_t id = 0; id < m_streams.size(); id++)
+      if(m_streams[id].used && !m_streams[id].que.empty())
+	m_heap.emplace_back(m_streams[id].que.front().key, id);
+    std::make_heap(m_heap.begin(), m_heap.end(), std::greater<Head>());
+  }
+
+  bool EventBuilder::Push(uint32_t id, uint64_t key, EventSPC ev){
+    if(id >= m_streams.size() || !m_streams[id].used || !m_streams[id].active)
+      EUDAQ_THROW("EventBuilder: Push to an unknown stream");
+    auto &s = m_streams[id];
+    if((m_has_last && key <= m_last_key) || (!s.que.empty() && key <= s.que.back().key)){
+      m_n_late++;
+      return false;
+    }
+    // the arrival time is only needed for the timeout
+    s.que.push_back(Frag{key, std::move(ev),
+			 m_timeout.count() ? Clock::now() : Clock::time_point()});
+    m_n_pending++;
+    if(s.que.size() == 1){
+      m_n_empty--;
+      m_heap.emplace_back(key, id);
+      std::push_heap(m_heap.begin(), m_heap.end(), std::greater<Head>());
+    }
+    if(m_max_queue && s.que.size() == m_max_queue + 1)
+      m_n_over++;
+    return true;
+  }
+
+  EventBuilder::Frag EventBuilder::PopFront(uint32_t id){
+    auto &s = m_streams[id];
+    if(m_max_queue && s.que.size() == m_max_queue + 1)
+      m_n_over--;
+    Frag f = std::move(s.que.front());
+    s.que.pop_front();
+    m_n_pending--;
+    if(!s.que.empty()){
+      m_heap.emplace_back(s.que.front().key, id);
+      std::push_heap(m_heap.begin(), m_heap.end(), std::greater<Head>());
+    }
+    else if(s.active)
+      m_n_empty++;
+    else
+      Erase(id); // drained
+    return f;
+  }
+
+  bool EventBuilder::Forced(){
+    if(m_max_queue && m_n_over)
+      return true;
+    if(m_timeout.count()){
+      auto &head = m_streams[m_heap.front().second].que.front();
+      return Clock::now() - head.t >= m_timeout;
+    }
+    return false;
+  }
+
+  bool EventBuilder::Next(Built &out){
+    for(;;){
+      if(m_heap.empty())
+	return false;
+      if(m_n_empty && (m_policy == MISSING_WAIT || !Forced()))
+	return false;
+      uint64_t key = m_heap.front().first;
+      uint32_t n_active = m_n_active;
+      uint32_t n_got = 0;
+      out.key = key;
+      out.frags.clear();
+      while(!m_heap.empty() && m_heap.front().first == key){
+	std::pop_heap(m_heap.begin(), m_heap.end(), std::greater<Head>());
+	uint32_t id = m_heap.back().second;
+	m_heap.pop_back();
+	if(m_streams[id].active)
+	  n_got++;
+	out.frags.push_back(PopFront(id).ev);
+      }
+      out.missing = n_active - n_got;
+      m_has_last = true;
+      m_last_key = key;
+      if(out.missing){
+	if(m_policy == MISSING_DROP){
+	  m_n_dropped++;
+	  continue;
+	}
+	m_n_incomplete++;
+      }
+      m_n_built++;
+      return true;
+    }
+  }
+
+  void EventBuilder::Clear(){
+    for(uint32_t id = 0; id < m_streams.size(); id++){
+      auto &s = m_streams[id];
+      if(!s.used)
+	continue;
+      if(!s.active){
+	Erase(id);
+	continue;
+      }
+      if(!s.que.empty()){
+	s.que.clear();
+	m_n_empty++;
+      }
+    }
+    m_heap.clear();
+    m_n_over = 0;
+    m_n_pending = 0;
+    m_has_last = false;
+    m_n_built = 0;
+    m_n_incomplete = 0;
+    m_n_dropped = 0;
+    m_n_late = 0;
+  }
+}
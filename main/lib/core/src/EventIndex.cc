@@ -0,0 +1,202 @@
+#include "eudaq/EventIndex.hh"
+#include "eudaq/FileDeserializer.hh"
+#include "eudaq/Factory.hh"
+#include "eudaq/Logger.hh"
+#include "eudaq/Utils.hh"
+
+#include <cstdio>
+
+namespace eudaq {
+  namespace {
+    const uint32_t INDEX_MAGIC = cstr2hash("EUDAQIDX");
+    const uint32_t INDEX_VERSION = 1;
+
+    void WriteEntry(Serializer &ser, const EventIndex::Entry &e){
+      ser.write(e.offset);
+      ser.write(e.event_n);
+      ser.write(e.trigger_n);
+      ser.write(e.ts_begin);
+      ser.write(e.ts_end);
+      ser.write(e.flags);
+    }
+
+    void WriteHeader(Serializer &ser){
+      ser.write(INDEX_MAGIC);
+      ser.write(INDEX_VERSION);
+    }
+
+    bool FileSize(const std::string &path, uint64_t &size){
+      FILE *f = fopen(path.c_str(), "rb");
+      if(!f)
+        return false;
+#if EUDAQ_PLATFORM_IS(WIN32)
+      bool ok = _fseeki64(f, 0, SEEK_END) == 0;
+      int64_t pos = ok ? _ftelli64(f) : -1;
+#else
+      bool ok = fseeko(f, 0, SEEK_END) == 0;
+      int64_t pos = ok ? ftello(f) : -1;
+#endif
+      fclose(f);
+      if(pos < 0)
+        return false;
+      size = pos;
+      return true;
+    }
+
+    bool SameEntry(const EventIndex::Entry &a, const EventIndex::Entry &b){
+      return a.offset == b.offset && a.event_n == b.event_n &&
+        a.trigger_n == b.trigger_n && a.ts_begin == b.ts_begin &&
+        a.ts_end == b.ts_end && a.flags == b.flags;
+    }
+  }
+
+  std::string EventIndex::IndexPath(const std::string &raw_path){
+    return raw_path + ".idx";
+  }
+
+  EventIndex::Entry EventIndex::MakeEntry(const Event &ev, uint64_t offset){
+    Entry e;
+    e.offset = offset;
+    e.event_n = ev.GetEventN();
+    e.trigger_n = ev.GetTriggerN();
+    e.ts_begin = ev.GetTimestampBegin();
+    e.ts_end = ev.GetTimestampEnd();
+    e.flags = ev.GetFlag();
+    return e;
+  }
+
+  EventIndexSP EventIndex::Load(const std::string &idx_path){
+    EventIndexSP idx(new EventIndex);
+    FileDeserializer des(idx_path, true);
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    try{
+      des.read(magic);
+      des.read(version);
+    }catch(const FileReadException &){
+    }
+    if(magic != INDEX_MAGIC || version != INDEX_VERSION)
+      EUDAQ_THROWX(FileFormatException, "Not an event index file: " + idx_path);
+    Entry e;
+    try{
+      while(des.HasData()){
+        des.read(e.offset);
+        des.read(e.event_n);
+        des.read(e.trigger_n);
+        des.read(e.ts_begin);
+        des.read(e.ts_end);
+        des.read(e.flags);
+        idx->Add(e);
+      }
+    }catch(const FileReadException &){
+      // the writer was interrupted in the middle of an entry
+      EUDAQ_WARN("EventIndex: truncated entry at the end of " + idx_path);
+    }
+    return idx;
+  }
+
+  EventIndexSP EventIndex::Open(const std::string &raw_path){
+    std::string idx_path = IndexPath(raw_path);
+    uint64_t raw_size = 0;
+    uint64_t idx_size = 0;
+    if(!FileSize(idx_path, idx_size) || !FileSize(raw_path, raw_size))
+      return nullptr;
+    EventIndexSP idx;
+    try{
+      idx = Load(idx_path);
+    }catch(const Exception &e){
+      EUDAQ_WARN(std::string("EventIndex: ignoring ") + idx_path + ", " + e.what());
+      return nullptr;
+    }
+    if(idx->Size() && !idx->Matches(raw_path, raw_size)){
+      EUDAQ_WARN("EventIndex: "+ idx_path + " does not match " + raw_path + ", ignoring it");
+      return nullptr;
+    }
+    return idx;
+  }
+
+  // The index is written along with the raw file, so there is nothing known
+  // about the final raw file when its header is written. Instead the first,
+  // middle and last events are read back and compared with their entries,
+  // which catches an index of another or a rewritten file.
+  bool EventIndex::Matches(const std::string &raw_path, uint64_t raw_size) const{
+    if(m_entries.back().offset >= raw_size)
+      return false;
+    try{
+      FileDeserializer des(raw_path, true);
+      size_t n = m_entries.size();
+      for(size_t i: {size_t(0), n / 2, n - 1}){
+        const Entry &e = m_entries[i];
+        des.Seek(e.offset);
+        uint32_t id;
+        des.PreRead(id);
+        EventUP ev = Factory<Event>::Create<Deserializer&>(id, des);
+        if(!ev || !SameEntry(MakeEntry(*ev, e.offset), e))
+          return false;
+      }
+    }catch(const std::exception &){
+      // also a bad_alloc from garbage lengths at a wrong offset
+      return false;
+    }
+    return true;
+  }
+
+  EventIndexSP EventIndex::Build(const std::string &raw_path){
+    EventIndexSP idx(new EventIndex);
+    FileDeserializer des(raw_path, true);
+    uint64_t offset = 0;
+    try{
+      while(des.HasData()){
+        offset = des.Tell();
+        uint32_t id;
+        des.PreRead(id);
+        EventUP ev = Factory<Event>::Create<Deserializer&>(id, des);
+        if(!ev)
+          EUDAQ_THROWX(FileFormatException, "Unknown event type at offset " +
+                       to_string(offset) + " of " + raw_path);
+        idx->Add(MakeEntry(*ev, offset));
+      }
+    }catch(const FileReadException &){
+      EUDAQ_WARN("EventIndex: truncated event at offset " + to_string(offset) +
+                 " of " + raw_path);
+    }
+    return idx;
+  }
+
+  void EventIndex::Save(const std::string &idx_path, bool overwrite) const{
+    FileSerializer ser(idx_path, overwrite);
+    WriteHeader(ser);
+    for(auto &e: m_entries)
+      WriteEntry(ser, e);
+    ser.Flush();
+  }
+
+  std::vector<uint32_t> EventIndex::Select(uint32_t evl, uint32_t evh,
+                                           uint32_t tgl, uint32_t tgh,
+                                           uint64_t tsl, uint64_t tsh) const{
+    std::vector<uint32_t> pos;
+    bool cut_ev = evl || evh;
+    bool cut_tg = tgl || tgh;
+    bool cut_ts = tsl || tsh;
+    for(uint32_t i = 0; i < m_entries.size(); i++){
+      auto &e = m_entries[i];
+      if(cut_ev && (e.event_n < evl || e.event_n >= evh))
+        continue;
+      if(cut_tg && (e.trigger_n < tgl || e.trigger_n >= tgh))
+        continue;
+      if(cut_ts && (e.ts_begin < tsl || e.ts_end > tsh))
+        continue;
+      pos.push_back(i);
+    }
+    return pos;
+  }
+
+  EventIndexWriter::EventIndexWriter(const std::string &idx_path, bool overwrite)
+    :m_ser(idx_path, overwrite){
+    WriteHeader(m_ser);
+  }
+
+  void EventIndexWriter::Write(const EventIndex::Entry &e){
+    WriteEntry(m_ser, e);
+  }
+}
@@ -8,10 +8,16 @@
 #include <iostream>
 
 namespace eudaq {
+  namespace {
+    // a smaller block gets a buffer of its own, so that keeping it does not
+    // keep a whole arena alive
+    const size_t SMALL_BLOCK = 4096;
+  }
+
   FileDeserializer::FileDeserializer(const std::string &fname, bool faileof,
                                      size_t buffersize)
       : m_file(0), m_faileof(faileof), m_buf(buffersize), m_start(&m_buf[0]),
-        m_stop(m_start) {
+        m_stop(m_start), m_file_pos(0), m_arena_size(0), m_arena_offset(0) {
     m_file = fopen(fname.c_str(), "rb");
     if (!m_file)
       EUDAQ_THROWX(FileNotFoundException, "Unable to open file: " + fname);
@@ -57,6 +63,7 @@ namespace eudaq {
     size_t read =
         fread(reinterpret_cast<char *>(m_stop), 1, end - m_stop, m_file);
     m_stop += read;
+    m_file_pos += read;
     while (read < min) {
       if (feof(m_file) && m_faileof) {
         throw FileReadException("End of File encountered");
@@ -73,10 +80,24 @@ namespace eudaq {
           fread(reinterpret_cast<char *>(m_stop), 1, end - m_stop, m_file);
       read += bytes;
       m_stop += bytes;
+      m_file_pos += bytes;
     }
     return read;
   }
 
+  void FileDeserializer::Seek(uint64_t pos) {
+#if EUDAQ_PLATFORM_IS(WIN32)
+    int err = _fseeki64(m_file, pos, SEEK_SET);
+#else
+    int err = fseeko(m_file, pos, SEEK_SET);
+#endif
+    if (err != 0)
+      EUDAQ_THROWX(FileReadException, "Seek to " + to_string(pos) + " failed");
+    clearerr(m_file);
+    m_start = m_stop = &m_buf[0];
+    m_file_pos = pos;
+  }
+
   void FileDeserializer::Deserialize(uint8_t *data, size_t len) {
     if (len <= level()) {
       // The buffer contains enough data
@@ -101,6 +122,27 @@ namespace eudaq {
     }
   }
 
+  DataBlock FileDeserializer::DeserializeBlock(size_t len) {
+    if (len < SMALL_BLOCK) {
+      std::vector<uint8_t> buf(len);
+      if (len)
+        Deserialize(buf.data(), len);
+      return DataBlock(std::move(buf));
+    }
+    if (!m_arena || m_arena_size - m_arena_offset < len) {
+      // left uninitialized, it is filled from the file
+      m_arena_size = std::max(len, m_buf.size());
+      m_arena = std::shared_ptr<uint8_t>(new uint8_t[m_arena_size],
+                                         std::default_delete<uint8_t[]>());
+      m_arena_offset = 0;
+    }
+    uint8_t *dst = m_arena.get() + m_arena_offset;
+    Deserialize(dst, len);
+    DataBlock block(std::shared_ptr<const uint8_t>(m_arena, dst), len);
+    m_arena_offset += len;
+    return block;
+  }
+
   void FileDeserializer::PreDeserialize(uint8_t *data, size_t len) {
     if (len <= level()) {
       memcpy(data, m_start, len);
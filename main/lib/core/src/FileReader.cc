@@ -16,6 +16,12 @@ namespace eudaq {
   FileReader::~FileReader(){ 
   }
 
+  EventSPC FileReader::GetEvent(uint32_t i){
+    if(!Seek(i))
+      return nullptr;
+    return GetNextEvent();
+  }
+
   FileReaderSP FileReader::Make(std::string type, std::string path){
       auto fw = eudaq::Factory<eudaq::FileReader>::MakeShared(eudaq::str2hash(type), path);
       if(!fw)
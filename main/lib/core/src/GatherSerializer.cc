@@ -0,0 +1,47 @@
+#include "eudaq/GatherSerializer.hh"
+
+namespace eudaq {
+  GatherSerializer::GatherSerializer(size_t min_ref)
+    : m_min_ref(min_ref), m_start(0), m_ref_size(0) {
+    m_buf.reserve(256);
+    m_wr_buf = &m_buf;
+  }
+
+  void GatherSerializer::Serialize(const uint8_t *data, size_t len) {
+    m_buf.insert(m_buf.end(), data, data + len);
+  }
+
+  void GatherSerializer::SerializeBlock(const uint8_t *data, size_t len) {
+    if (len < m_min_ref) {
+      append(data, len);
+      return;
+    }
+    if (m_buf.size() > m_start)
+      m_parts.push_back(Part{nullptr, m_start, m_buf.size() - m_start});
+    m_parts.push_back(Part{data, 0, len});
+    m_start = m_buf.size();
+    m_ref_size += len;
+  }
+
+  std::vector<BlockView> GatherSerializer::Parts() const {
+    // the buffer may have been reallocated, so resolve its pointers only now
+    std::vector<BlockView> parts;
+    parts.reserve(m_parts.size() + 1);
+    for (auto &p : m_parts) {
+      if (p.ptr)
+        parts.emplace_back(p.ptr, p.len);
+      else
+        parts.emplace_back(m_buf.data() + p.offset, p.len);
+    }
+    if (m_buf.size() > m_start)
+      parts.emplace_back(m_buf.data() + m_start, m_buf.size() - m_start);
+    return parts;
+  }
+
+  void GatherSerializer::clear() {
+    m_buf.clear();
+    m_parts.clear();
+    m_start = 0;
+    m_ref_size = 0;
+  }
+}
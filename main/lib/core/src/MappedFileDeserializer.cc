@@ -0,0 +1,126 @@
+#include "eudaq/MappedFileDeserializer.hh"
+#include "eudaq/Utils.hh"
+#include <cstring>
+
+#if EUDAQ_PLATFORM_IS(WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace eudaq {
+
+  MappedFileDeserializer::MappedFileDeserializer(const std::string &fname)
+    : m_size(0), m_sequential(false) {
+#if EUDAQ_PLATFORM_IS(WIN32)
+    HANDLE file = CreateFileA(fname.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+			      OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+      EUDAQ_THROWX(FileNotFoundException, "Unable to open file: " + fname);
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+      CloseHandle(file);
+      EUDAQ_THROWX(FileReadException, "Unable to get the size of file: " + fname);
+    }
+    m_size = size.QuadPart;
+    if (m_size == 0) {
+      CloseHandle(file);
+      return;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!mapping)
+      EUDAQ_THROWX(FileReadException, "Unable to map file: " + fname);
+    void *addr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!addr)
+      EUDAQ_THROWX(FileReadException, "Unable to map file: " + fname);
+    m_map = std::shared_ptr<const uint8_t>(static_cast<const uint8_t *>(addr),
+					   [](const uint8_t *p) {
+					     UnmapViewOfFile(p);
+					   });
+#else
+    int fd = open(fname.c_str(), O_RDONLY);
+    if (fd < 0)
+      EUDAQ_THROWX(FileNotFoundException, "Unable to open file: " + fname);
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      close(fd);
+      EUDAQ_THROWX(FileReadException, "Unable to get the size of file: " + fname);
+    }
+    m_size = st.st_size;
+    if (m_size == 0) {
+      close(fd);
+      return;
+    }
+    void *addr = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+      EUDAQ_THROWX(FileReadException, "Unable to map file: " + fname);
+    madvise(addr, m_size, MADV_SEQUENTIAL);
+    m_sequential = true;
+    uint64_t size = m_size;
+    m_map = std::shared_ptr<const uint8_t>(static_cast<const uint8_t *>(addr),
+					   [size](const uint8_t *p) {
+					     munmap(const_cast<uint8_t *>(p), size);
+					   });
+#endif
+    m_rd_data = m_map.get();
+    m_rd_size = static_cast<size_t>(m_size);
+  }
+
+  MappedFileDeserializer::~MappedFileDeserializer() {
+  }
+
+  bool MappedFileDeserializer::HasData() {
+    return m_rd_pos < m_size;
+  }
+
+  void MappedFileDeserializer::Seek(uint64_t pos) {
+    if (pos > m_size)
+      EUDAQ_THROWX(FileReadException, "Seek beyond the end of file (" +
+		   to_string(pos) + " > " + to_string(m_size) + ")");
+    m_rd_pos = pos;
+  }
+
+  void MappedFileDeserializer::SetSequential(bool seq) {
+    if (seq == m_sequential || !m_map)
+      return;
+#if !EUDAQ_PLATFORM_IS(WIN32)
+    madvise(const_cast<uint8_t *>(m_map.get()), m_size,
+	    seq ? MADV_SEQUENTIAL : MADV_NORMAL);
+#endif
+    m_sequential = seq;
+  }
+
+  void MappedFileDeserializer::CheckAvailable(size_t len) const {
+    if (len > m_size - m_rd_pos)
+      EUDAQ_THROWX(FileReadException, "End of File encountered, asked for " +
+		   to_string(len) + ", only have " + to_string(m_size - m_rd_pos));
+  }
+
+  void MappedFileDeserializer::Deserialize(uint8_t *data, size_t len) {
+    if (!len)
+      return;
+    CheckAvailable(len);
+    std::memcpy(data, m_map.get() + m_rd_pos, len);
+    m_rd_pos += len;
+  }
+
+  void MappedFileDeserializer::PreDeserialize(uint8_t *data, size_t len) {
+    if (!len)
+      return;
+    CheckAvailable(len);
+    std::memcpy(data, m_map.get() + m_rd_pos, len);
+  }
+
+  DataBlock MappedFileDeserializer::DeserializeBlock(size_t len) {
+    CheckAvailable(len);
+    DataBlock block(std::shared_ptr<const uint8_t>(m_map, m_map.get() + m_rd_pos), len);
+    m_rd_pos += len;
+    return block;
+  }
+}
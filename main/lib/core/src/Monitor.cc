@@ -68,6 +68,11 @@ namespace eudaq {
     auto conf = GetConfiguration();
     try {
       SetStatus(Status::STATE_UNCONF, "Configuring");
+      // a monitor should never hold back the producers
+      SetFlowControl(conf->Get("EUDAQ_MN_FLOW", "drop"),
+		     conf->Get("EUDAQ_MN_QUEUE_BYTES", uint64_t(64) << 20),
+		     conf->Get("EUDAQ_MN_SPILL_DIR", ""));
+      SetDecodeThreads(conf->Get("EUDAQ_MN_DECODE_THREADS", -1));
       DoConfigure();
       CommandReceiver::OnConfigure();
     }catch (const Exception &e) {
@@ -128,6 +133,8 @@ namespace eudaq {
     
   void Monitor::OnStatus(){
     SetStatusTag("EventN", std::to_string(m_evt_c));
+    for(auto &e: GetQueueStatus())
+      SetStatusTag(e.first, e.second);
     DoStatus();
     CommandReceiver::OnStatus();
   }
@@ -1,13 +1,32 @@
 #include "eudaq/FileDeserializer.hh"
+#include "eudaq/MappedFileDeserializer.hh"
 #include "eudaq/FileReader.hh"
+#include "eudaq/EventIndex.hh"
 
 class NativeFileReader : public eudaq::FileReader {
 public:
   NativeFileReader(const std::string& filename);
   eudaq::EventSPC GetNextEvent()override;
+  bool Seek(uint32_t i) override;
+  eudaq::EventIndexSPC GetIndex() const override {return m_index;};
+protected:
+  bool m_mmap;
 private:
+  void Open();
+  uint64_t Tell() const;
+  void SeekOffset(uint64_t pos);
+  eudaq::EventUP ReadEvent();
   std::unique_ptr<eudaq::FileDeserializer> m_des;
+  std::unique_ptr<eudaq::MappedFileDeserializer> m_map;
   std::string m_filename;
+  eudaq::EventIndexSP m_index;
+  std::vector<uint64_t> m_offsets; // file offsets of the events seen so far
+  uint32_t m_next; // index of the event to be returned by GetNextEvent
+};
+
+class MmapNativeFileReader : public NativeFileReader {
+public:
+  MmapNativeFileReader(const std::string& filename);
 };
 
 namespace{
@@ -15,26 +34,83 @@ namespace{
     Register<NativeFileReader, std::string&>(eudaq::cstr2hash("native"));
   auto dummy1 = eudaq::Factory<eudaq::FileReader>::
     Register<NativeFileReader, std::string&&>(eudaq::cstr2hash("native"));
+  auto dummy2 = eudaq::Factory<eudaq::FileReader>::
+    Register<MmapNativeFileReader, std::string&>(eudaq::cstr2hash("mmap"));
+  auto dummy3 = eudaq::Factory<eudaq::FileReader>::
+    Register<MmapNativeFileReader, std::string&&>(eudaq::cstr2hash("mmap"));
 }
 
 NativeFileReader::NativeFileReader(const std::string& filename)
-  :m_filename(filename){    
+  :m_mmap(false), m_filename(filename), m_next(0){
+  m_index = eudaq::EventIndex::Open(filename);
+  if(m_index){
+    for(size_t i = 0; i < m_index->Size(); i++)
+      m_offsets.push_back(m_index->At(i).offset);
+  }
 }
 
-eudaq::EventSPC NativeFileReader::GetNextEvent(){
-  if(!m_des){
+MmapNativeFileReader::MmapNativeFileReader(const std::string& filename)
+  :NativeFileReader(filename){
+  m_mmap = true;
+}
+
+void NativeFileReader::Open(){
+  if(m_mmap)
+    m_map.reset(new eudaq::MappedFileDeserializer(m_filename));
+  else
     m_des.reset(new eudaq::FileDeserializer(m_filename));
-    if(!m_des)
-      EUDAQ_THROW("unable to open file: " + m_filename);
-  }
-  eudaq::EventUP ev;
+}
+
+uint64_t NativeFileReader::Tell() const{
+  return m_mmap ? m_map->Tell() : m_des->Tell();
+}
+
+void NativeFileReader::SeekOffset(uint64_t pos){
+  if(m_mmap)
+    m_map->Seek(pos);
+  else
+    m_des->Seek(pos);
+}
+
+eudaq::EventUP NativeFileReader::ReadEvent(){
+  eudaq::Deserializer &des = m_mmap ? static_cast<eudaq::Deserializer&>(*m_map)
+    : static_cast<eudaq::Deserializer&>(*m_des);
+  if(!des.HasData())
+    return nullptr;
+  if(m_next == m_offsets.size())
+    m_offsets.push_back(Tell());
   uint32_t id;
-  
-  if(m_des->HasData()){
-    m_des->PreRead(id);
-    ev = eudaq::Factory<eudaq::Event>::
-      Create<eudaq::Deserializer&>(id, *m_des);
-    return std::move(ev);
-  }  else  return nullptr;
-  
+  des.PreRead(id);
+  eudaq::EventUP ev = eudaq::Factory<eudaq::Event>::
+    Create<eudaq::Deserializer&>(id, des);
+  if(ev)
+    m_next++;
+  return ev;
+}
+
+eudaq::EventSPC NativeFileReader::GetNextEvent(){
+  if(!m_des && !m_map)
+    Open();
+  return ReadEvent();
+}
+
+bool NativeFileReader::Seek(uint32_t i){
+  if(!m_des && !m_map)
+    Open();
+  if(m_mmap && i != m_next)
+    m_map->SetSequential(false);
+  if(i < m_offsets.size()){
+    SeekOffset(m_offsets[i]);
+    m_next = i;
+    return true;
+  }
+  if(!m_offsets.empty() && m_next < m_offsets.size()){
+    SeekOffset(m_offsets.back());
+    m_next = m_offsets.size() - 1;
+  }
+  while(m_next < i){
+    if(!ReadEvent())
+      return false;
+  }
+  return true;
 }
@@ -1,16 +1,27 @@
 #include "eudaq/FileNamer.hh"
 #include "eudaq/FileWriter.hh"
 #include "eudaq/FileSerializer.hh"
+#include "eudaq/AsyncFileSerializer.hh"
+#include "eudaq/EventIndex.hh"
 
 class NativeFileWriter : public eudaq::FileWriter {
 public:
   NativeFileWriter(const std::string &patt);
   void WriteEvent(eudaq::EventSPC ev) override;
+  void WriteEvents(const std::vector<eudaq::EventSPC> &evs) override;
   uint64_t FileBytes() const override;
+  std::string FileName() const override {return m_filename;};
 private:
+  void Open(uint32_t run_n);
+  void Put(const eudaq::Event &ev);
+  void Flush();
   std::unique_ptr<eudaq::FileSerializer> m_ser;
+  std::unique_ptr<eudaq::AsyncFileSerializer> m_async;
+  std::unique_ptr<eudaq::EventIndexWriter> m_idx;
   std::string m_filepattern;
+  std::string m_filename;
   uint32_t m_run_n;
+  bool m_flush_eore;
 };
 
 namespace{
@@ -20,31 +31,87 @@ namespace{
     Register<NativeFileWriter, std::string&&>(eudaq::cstr2hash("native"));
 }
 
-NativeFileWriter::NativeFileWriter(const std::string &patt){
+NativeFileWriter::NativeFileWriter(const std::string &patt)
+  :m_run_n(0), m_flush_eore(true){
   m_filepattern = patt;
 }
-  
+
+void NativeFileWriter::Open(uint32_t run_n){
+  std::time_t time_now = std::time(nullptr);
+  char time_buff[13];
+  time_buff[12] = 0;
+  std::strftime(time_buff, sizeof(time_buff),
+		"%y%m%d%H%M%S", std::localtime(&time_now));
+  std::string time_str(time_buff);
+  std::string filename = eudaq::FileNamer(m_filepattern).
+    Set('X', ".raw").
+    Set('R', run_n).
+    Set('D', time_str);
+  m_idx.reset();
+  m_ser.reset();
+  m_async.reset();
+  auto conf = GetConfiguration();
+  if(conf && conf->Get("EUDAQ_FW_ASYNC", 0)){
+    // serialized events are batched in memory and written by an I/O thread
+    uint64_t flush_bytes = conf->Get("EUDAQ_FW_FLUSH_BYTES", uint64_t(4 << 20));
+    uint32_t flush_ms = conf->Get("EUDAQ_FW_FLUSH_MS", 1000);
+    uint64_t max_pending = conf->Get("EUDAQ_FW_BUFFER_BYTES", uint64_t(256 << 20));
+    m_flush_eore = conf->Get("EUDAQ_FW_FLUSH_EORE", 1);
+    m_async.reset(new eudaq::AsyncFileSerializer(filename, false, flush_bytes,
+						 flush_ms, max_pending));
+  }
+  else
+    m_ser.reset(new eudaq::FileSerializer(filename));
+  if(conf && conf->Get("EUDAQ_FW_INDEX", 0))
+    m_idx.reset(new eudaq::EventIndexWriter(eudaq::EventIndex::IndexPath(filename)));
+  m_filename = filename;
+  m_run_n = run_n;
+}
+
 void NativeFileWriter::WriteEvent(eudaq::EventSPC ev) {
-  uint32_t run_n = ev->GetRunN();
-  if(!m_ser || m_run_n != run_n){
-    std::time_t time_now = std::time(nullptr);
-    char time_buff[13];
-    time_buff[12] = 0;
-    std::strftime(time_buff, sizeof(time_buff),
-		  "%y%m%d%H%M%S", std::localtime(&time_now));
-    std::string time_str(time_buff);
-    m_ser.reset(new eudaq::FileSerializer((eudaq::FileNamer(m_filepattern).
-					   Set('X', ".raw").
-					   Set('R', run_n).
-					   Set('D', time_str))));
-    m_run_n = run_n;
+  Put(*ev);
+  Flush();
+}
+
+void NativeFileWriter::WriteEvents(const std::vector<eudaq::EventSPC> &evs) {
+  // a single flush for the whole batch
+  for(auto &ev: evs)
+    Put(*ev);
+  Flush();
+}
+
+void NativeFileWriter::Put(const eudaq::Event &ev) {
+  uint32_t run_n = ev.GetRunN();
+  if((!m_ser && !m_async) || m_run_n != run_n)
+    Open(run_n);
+  uint64_t offset;
+  if(m_async){
+    offset = m_async->Write(ev);
+    if(m_flush_eore && ev.IsEORE())
+      m_async->Flush();
+  }
+  else if(m_ser){
+    offset = m_ser->FileBytes();
+    m_ser->write(ev);
   }
-  if(!m_ser)
+  else
     EUDAQ_THROW("NativeFileWriter: Attempt to write unopened file");
-  m_ser->write(*(ev.get())); //TODO: Serializer accepts EventSPC
-  m_ser->Flush();
+  if(m_idx){
+    m_idx->Write(eudaq::EventIndex::MakeEntry(ev, offset));
+    if(m_async && ev.IsEORE())
+      m_idx->Flush();
+  }
+}
+
+void NativeFileWriter::Flush() {
+  if(m_ser)
+    m_ser->Flush();
+  if(m_idx && !m_async)
+    m_idx->Flush();
 }
   
 uint64_t NativeFileWriter::FileBytes() const {
+  if(m_async)
+    return m_async->FileBytes();
   return m_ser ?m_ser->FileBytes() :0;
 }
@@ -1,17 +1,29 @@
 #include "Processor.hh"
 #include "Utils.hh"
+#include "Logger.hh"
 
 using namespace eudaq;
 
 template DLLEXPORT
 std::map<uint32_t, typename Factory<Processor>::UP_BASE (*)()>& Factory<Processor>::Instance<>();
 
+namespace{
+  // the stateless processor, and its slot, whose ProcessEvent runs on this thread
+  thread_local const Processor *tl_ps = nullptr;
+  thread_local void *tl_slot = nullptr;
+
+  // the last task of a node may be the one dropping the node, an executor
+  // cannot wait for its own thread
+  void Retire(std::unique_ptr<TaskExecutor> ex){
+    if(ex && ex->IsWorkerThread())
+      std::thread([](TaskExecutor *p){delete p;}, ex.release()).detach();
+  }
+}
+
 ProcessorSP Processor::MakeShared(const std::string& pstype,
 				  std::initializer_list
 				  <std::pair<const std::string, const std::string>> l){
   ProcessorSP ps = Factory<Processor>::MakeShared(str2hash(pstype));
-  ps->m_th_hub = std::thread(&Processor::HubProcessing, ps.get());
-  ps->m_ps_hub = ps;
   for(auto &p: l){
     ps->ProcessSysCommand(p.first, p.second);
   }
@@ -20,41 +32,31 @@ ProcessorSP Processor::MakeShared(const std::string& pstype,
 
 
 Processor::Processor(const std::string& dsp)
-  :m_description(dsp), m_csm_go_stop(0), m_hub_go_stop(0), m_hub_force(0){
+  :m_description(dsp), m_stateless(false), m_que_in(4096), m_scheduled(false),
+   m_pdc_go_stop(false){
   m_instance_n = static_cast<uint32_t>(reinterpret_cast<uint64_t>(this));
 }
 
 Processor::~Processor(){
   StopProducer();
-  if(m_th_hub.joinable()){
-    m_hub_go_stop = true;
-    m_th_hub.join();
-    m_hub_go_stop = false;
-  }
-  if(m_th_csm.joinable()){
-    m_csm_go_stop = true;
-    m_th_csm.join();
-    m_csm_go_stop = false;
-  }
+  Retire(std::move(m_exec));
 };
 
 void Processor::ProcessEvent(EventSPC ev){
   ForwardEvent(ev);
 }
 
-void Processor::Processing(EventSPC ev){
-  if(m_th_csm.joinable() && !m_csm_go_stop){
-    std::unique_lock<std::mutex> lk(m_mtx_csm);
-    m_que_csm.push_back(ev);
-    m_cv_csm.notify_all();
-  }
-  else{
+void Processor::ProcessEvents(const std::vector<EventSPC> &evs){
+  for(auto &ev: evs)
     ProcessEvent(ev);
-  }
 }
 
-
 void Processor::ForwardEvent(EventSPC ev) {
+  if(tl_ps == this){
+    // released in order once the events before are done, see RunStateless
+    static_cast<Slot*>(tl_slot)->out.push_back(std::move(ev));
+    return;
+  }
   std::lock_guard<std::mutex> lk(m_mtx_output);
   uint32_t evid = ev->GetEventID();
   for(auto &psev: m_ps_downstream){
@@ -65,10 +67,95 @@ void Processor::ForwardEvent(EventSPC ev) {
   }
 }
 
+void Processor::ForwardEvents(const std::vector<EventSPC> &evs) {
+  if(evs.empty())
+    return;
+  if(tl_ps == this){
+    auto &out = static_cast<Slot*>(tl_slot)->out;
+    out.insert(out.end(), evs.begin(), evs.end());
+    return;
+  }
+  std::lock_guard<std::mutex> lk(m_mtx_output);
+  std::vector<EventSPC> sel;
+  for(auto &psev: m_ps_downstream){
+    auto &evset = psev.second;
+    sel.clear();
+    for(auto &ev: evs)
+      if(evset.find(ev->GetEventID())!=evset.end())
+	sel.push_back(ev);
+    if(sel.size() == evs.size())
+      psev.first->RegisterEvents(evs);
+    else if(!sel.empty())
+      psev.first->RegisterEvents(sel);
+  }
+}
+
 void Processor::RegisterEvent(EventSPC ev){
-  std::lock_guard<std::mutex> lk(m_mtx_input);
-  auto ps_hub = m_ps_hub.lock();
-  ps_hub->RegisterProcessing(shared_from_this(), ev);
+  if(m_stateless){
+    RegisterEvents(std::vector<EventSPC>(1, std::move(ev)));
+    return;
+  }
+  m_que_in.PushOrSpill(std::move(ev));
+  if(!m_scheduled.exchange(true)){
+    auto self = shared_from_this();
+    Schedule([self](){self->RunOrdered();});
+  }
+}
+
+void Processor::RegisterEvents(const std::vector<EventSPC> &evs){
+  if(evs.empty())
+    return;
+  auto self = shared_from_this();
+  if(m_stateless){
+    // the batch is one task and keeps its place in the order as a whole
+    Slot *slot;
+    std::unique_lock<std::mutex> lk(m_mtx_slot);
+    m_slots.push_back(Slot{{}, false});
+    slot = &m_slots.back(); // stays valid, the deque only grows at the back
+    lk.unlock();
+    Schedule([self, evs, slot](){self->RunStateless(evs, slot);});
+    return;
+  }
+  for(auto &ev: evs)
+    m_que_in.PushOrSpill(EventSPC(ev));
+  if(!m_scheduled.exchange(true))
+    Schedule([self](){self->RunOrdered();});
+}
+
+void Processor::RunOrdered(){
+  // a bounded batch, then the other tasks get their turn
+  std::vector<EventSPC> evs;
+  EventSPC ev;
+  while(evs.size() < 64 && m_que_in.TryPop(ev))
+    evs.push_back(std::move(ev));
+  if(!evs.empty())
+    ProcessEvents(evs);
+  m_scheduled = false;
+  if(!m_que_in.Empty() && !m_scheduled.exchange(true)){
+    auto self = shared_from_this();
+    Schedule([self](){self->RunOrdered();});
+  }
+}
+
+void Processor::Schedule(TaskExecutor::Task t){
+  std::lock_guard<std::mutex> lk(m_mtx_exec);
+  (m_exec ? *m_exec : TaskExecutor::Instance()).Submit(std::move(t));
+}
+
+void Processor::RunStateless(const std::vector<EventSPC> &evs, Slot *slot){
+  auto ps = tl_ps;
+  auto sl = tl_slot;
+  tl_ps = this;
+  tl_slot = slot;
+  ProcessEvents(evs);
+  tl_ps = ps;
+  tl_slot = sl;
+  std::lock_guard<std::mutex> lk(m_mtx_slot);
+  slot->done = true;
+  while(!m_slots.empty() && m_slots.front().done){
+    ForwardEvents(m_slots.front().out);
+    m_slots.pop_front();
+  }
 }
 
 void Processor::RegisterDownstream(ProcessorSP ps, const std::set<uint32_t>& evset){
@@ -86,108 +173,18 @@ void Processor::RegisterDownstream(ProcessorSP ps, const std::set<uint32_t>& evs
   }
   if(!found){
     m_ps_downstream.push_back(std::make_pair(ps, evs));
-    ps->RegisterUpstream(shared_from_this(), m_ps_hub);
+    ps->RegisterUpstream(shared_from_this());
   }
 }
 
 
-void Processor::RegisterUpstream(ProcessorSP up, ProcessorWP hub){
+void Processor::RegisterUpstream(ProcessorSP up){
   std::lock_guard<std::mutex> lk(m_mtx_input);
-  bool found = false;
   for(auto &ps: m_ps_upstream){
-    if(up == ps.lock()){
-      found = true;
-      break;
-    }
-  }
-  if(!found)
-    m_ps_upstream.push_back(up);
-
-  //same
-  if(m_ps_hub.lock() == hub.lock())
-    return;
-  //forced
-  if(m_hub_force)
-    return;
-  //unforced, diff, single upstream
-  if(m_ps_upstream.size() < 2){
-    bool to_stop = false;
-    //unforced, diff, single upstream, self hub
-    if(m_ps_hub.lock() == shared_from_this()){
-      to_stop = true;
-    }
-    //else, unforced, diff, single upstream, other hub
-    m_ps_hub = hub;
-    for(auto &e: m_ps_downstream){
-      e.first->RegisterUpstream(shared_from_this(), m_ps_hub);
-    }
-    if(to_stop && m_th_hub.joinable()){
-	m_hub_go_stop = true;
-	m_th_hub.join();
-    }
-    return;
-  }
-  //unforced, diff, muilt upstreams, self hub ready
-  if(m_ps_hub.lock() == shared_from_this()){
-    return;
-  }
-  //unforced, diff, muilt upstreams, self hub unready  
-  m_th_hub = std::thread(&Processor::HubProcessing, this);
-  m_ps_hub = shared_from_this();
-  for(auto &e: m_ps_downstream){
-    e.first->RegisterUpstream(shared_from_this(),  m_ps_hub);
-  }
-  return;
-}
-
-
-void Processor::RegisterProcessing(ProcessorSP ps, EventSPC ev){ //NOTE:: return ps_hub_wk if not sucess
-  std::unique_lock<std::mutex> lk(m_mtx_hub);
-  if(m_hub_go_stop){
-    lk.unlock();
-    return; //register to new hub_ps of that ps
+    if(up == ps.lock())
+      return;
   }
-  m_que_hub.push_back(std::make_pair(ps, ev));
-  m_cv_hub.notify_all();
-}
-
-void Processor::HubProcessing(){
-  while(!m_hub_go_stop){
-    std::unique_lock<std::mutex> lk(m_mtx_hub);
-    if(m_que_hub.empty()){
-      if(m_cv_hub.wait_for(lk,std::chrono::microseconds(100))==std::cv_status::timeout)
-	continue;
-    }
-    ProcessorSP ps = m_que_hub.front().first;
-    EventSPC ev(m_que_hub.front().second);
-    m_que_hub.pop_front();
-    lk.unlock();
-    ps->Processing(ev);
-  }
-  std::unique_lock<std::mutex> lk(m_mtx_hub);
-  for(auto &ps_ev: m_que_hub){
-    ps_ev.first->Processing(ps_ev.second);
-  }
-  m_que_hub.clear();
-}
-
-void Processor::ConsumeEvent(){
-  while(!m_csm_go_stop){
-    std::unique_lock<std::mutex> lk(m_mtx_csm);
-    if(m_que_csm.empty()){
-      if(m_cv_csm.wait_for(lk,std::chrono::microseconds(100))==std::cv_status::timeout)
-	continue;
-    }
-    EventSPC ev(m_que_csm.front());
-    m_que_csm.pop_front();
-    lk.unlock();
-    ProcessEvent(ev);
-  }
-  std::unique_lock<std::mutex> lk(m_mtx_csm);
-  for(auto &ev: m_que_csm){
-    ProcessEvent(ev);
-  }
-  m_que_csm.clear();
+  m_ps_upstream.push_back(up);
 }
 
 void Processor::StopProducer(){
@@ -214,24 +211,27 @@ void Processor::ProcessSysCommand(const std::string& cmd, const std::string& arg
     break;
   }
   case cstr2hash("SYS:CS:RUN"):{
-    m_th_csm = std::thread(&Processor::ConsumeEvent, this);
+    std::lock_guard<std::mutex> lk(m_mtx_exec);
+    if(!m_exec)
+      m_exec.reset(new TaskExecutor(1));
     break;
   }
   case cstr2hash("SYS:CS:STOP"):{
-    if(m_th_csm.joinable()){
-      m_csm_go_stop = true;
-      m_th_csm.join();
-      m_csm_go_stop = false;
-    }
+    std::unique_lock<std::mutex> lk(m_mtx_exec);
+    std::unique_ptr<TaskExecutor> ex(std::move(m_exec));
+    lk.unlock();
+    // the queued tasks are run, what they schedule goes to the shared pool
+    Retire(std::move(ex));
     break;
   }
   case cstr2hash("SYS:HB:FORCE"):{
-    std::lock_guard<std::mutex> lk(m_mtx_input);
-    m_hub_force = true;
-    if(m_ps_hub.lock()!=shared_from_this()){
-      m_th_hub = std::thread(&Processor::HubProcessing, this);
-      m_ps_hub = shared_from_this();
-    }
+    EUDAQ_WARN("Processor " + m_description + ": SYS:HB:FORCE is obsolete, "
+	       "the nodes share one pool, SYS:CS:RUN gives a node its own thread");
+    break;
+  }
+  case cstr2hash("SYS:PS:STATELESS"):{
+    m_stateless = arg.empty() || std::stoul(arg) != 0;
+    break;
   }
   case cstr2hash("SYS:EV:ADD"):{
     std::lock_guard<std::mutex> lk(m_mtx_output);
@@ -258,7 +258,7 @@ void Processor::Print(std::ostream &os, uint32_t offset) const{
   os << std::string(offset, ' ') << "<Processor>\n";
   os << std::string(offset + 2, ' ') << "<Description> " << m_description <<" </Description>\n";
   os << std::string(offset + 2, ' ') << "<InstanceN> " << m_instance_n << " </InstanceN>\n";
-  os << std::string(offset + 2, ' ') << "<HubInstanceN> " << m_ps_hub.lock()->m_instance_n << " </HubInstanceN>\n";
+  os << std::string(offset + 2, ' ') << "<Stateless> " << m_stateless << " </Stateless>\n";
   if(!m_ps_upstream.empty()){
     os << std::string(offset + 2, ' ') << "<Upstreams> \n";
     for (auto &pswp: m_ps_upstream){
@@ -1,4 +1,5 @@
 #include "eudaq/StdEventConverter.hh"
+#include "eudaq/ConverterRegistry.hh"
 #include "eudaq/RawEvent.hh"
 
 namespace eudaq{
@@ -22,7 +23,7 @@ namespace eudaq{
     }
 
     uint32_t id = ev->GetExtendWord();
-    auto cvt = Factory<StdEventConverter>::MakeUnique(id);
+    auto cvt = ConverterRegistry<StdEventConverter>::Get(id, conf);
     if(cvt){
       cvt->Converting(d1, d2, conf);
       return true;
@@ -0,0 +1,47 @@
+#include "eudaq/RawzFile.hh"
+#include "eudaq/Exception.hh"
+#include "eudaq/Utils.hh"
+
+#ifdef EUDAQ_USE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace eudaq {
+  namespace rawz {
+#ifdef EUDAQ_USE_ZLIB
+    bool Available(){
+      return true;
+    }
+
+    std::vector<uint8_t> Compress(const uint8_t *data, size_t len, int level){
+      uLongf out_len = compressBound(len);
+      std::vector<uint8_t> out(out_len);
+      int err = compress2(out.data(), &out_len, data, len, level);
+      if(err != Z_OK)
+        EUDAQ_THROW("rawz: compression failed, zlib error " + to_string(err));
+      out.resize(out_len);
+      return out;
+    }
+
+    void Decompress(const uint8_t *data, size_t len, uint8_t *out, size_t out_len){
+      uLongf dst_len = out_len;
+      int err = uncompress(out, &dst_len, data, len);
+      if(err != Z_OK || dst_len != out_len)
+        EUDAQ_THROWX(FileFormatException, "rawz: corrupted chunk, zlib error " +
+                     to_string(err));
+    }
+#else
+    bool Available(){
+      return false;
+    }
+
+    std::vector<uint8_t> Compress(const uint8_t *, size_t, int){
+      EUDAQ_THROW("rawz: EUDAQ was built without zlib");
+    }
+
+    void Decompress(const uint8_t *, size_t, uint8_t *, size_t){
+      EUDAQ_THROW("rawz: EUDAQ was built without zlib");
+    }
+#endif
+  }
+}
@@ -0,0 +1,191 @@
+#include "eudaq/FileReader.hh"
+#include "eudaq/MappedFileDeserializer.hh"
+#include "eudaq/BufferSerializer.hh"
+#include "eudaq/RawzFile.hh"
+#include "eudaq/Logger.hh"
+
+#include <future>
+#include <algorithm>
+
+class RawzFileReader : public eudaq::FileReader {
+public:
+  RawzFileReader(const std::string& filename);
+  ~RawzFileReader() override;
+  eudaq::EventSPC GetNextEvent() override;
+  bool Seek(uint32_t i) override;
+private:
+  using ChunkUP = std::unique_ptr<eudaq::BufferSerializer>;
+  void Open();
+  void ScanChunks();
+  std::future<ChunkUP> DecodeChunk(size_t c, bool async);
+  bool LoadChunk(size_t c);
+  std::unique_ptr<eudaq::MappedFileDeserializer> m_map;
+  std::string m_filename;
+  std::vector<eudaq::rawz::ChunkInfo> m_chunks;
+  uint64_t m_events; // number of events in the file
+  ChunkUP m_cur;
+  size_t m_cur_chunk;
+  uint64_t m_left; // events not yet read from m_cur
+  // the chunk following m_cur is decompressed in the background
+  std::future<ChunkUP> m_prefetch;
+  size_t m_prefetch_chunk;
+};
+
+namespace{
+  auto dummy0 = eudaq::Factory<eudaq::FileReader>::
+    Register<RawzFileReader, std::string&>(eudaq::cstr2hash("rawz"));
+  auto dummy1 = eudaq::Factory<eudaq::FileReader>::
+    Register<RawzFileReader, std::string&&>(eudaq::cstr2hash("rawz"));
+}
+
+RawzFileReader::RawzFileReader(const std::string& filename)
+  :m_filename(filename), m_events(0), m_cur_chunk(0), m_left(0),
+   m_prefetch_chunk(0){
+}
+
+RawzFileReader::~RawzFileReader(){
+  if(m_prefetch.valid())
+    m_prefetch.wait();
+}
+
+void RawzFileReader::Open(){
+  m_map.reset(new eudaq::MappedFileDeserializer(m_filename));
+  uint32_t magic = 0, version = 0, codec = 0;
+  if(m_map->Size() >= eudaq::rawz::HEADER_SIZE){
+    m_map->read(magic);
+    m_map->read(version);
+    m_map->read(codec);
+  }
+  if(magic != eudaq::rawz::FILE_MAGIC)
+    EUDAQ_THROWX(eudaq::FileFormatException, "Not a rawz file: " + m_filename);
+  if(version != eudaq::rawz::VERSION || codec != eudaq::rawz::CODEC_ZLIB)
+    EUDAQ_THROWX(eudaq::FileFormatException, "Unsupported rawz version/codec: " + m_filename);
+
+  uint64_t size = m_map->Size();
+  if(size >= eudaq::rawz::HEADER_SIZE + eudaq::rawz::TRAILER_SIZE){
+    uint64_t index_offset;
+    m_map->Seek(size - eudaq::rawz::TRAILER_SIZE);
+    m_map->read(index_offset);
+    m_map->read(magic);
+    if(magic == eudaq::rawz::INDEX_MAGIC && index_offset < size){
+      m_map->Seek(index_offset);
+      uint32_t n;
+      m_map->read(n);
+      m_chunks.resize(n);
+      for(auto &c: m_chunks){
+	m_map->read(c.offset);
+	m_map->read(c.first_event);
+      }
+      m_events = 0;
+      if(n){
+	uint32_t raw_size, comp_size, n_events;
+	m_map->Seek(m_chunks.back().offset);
+	m_map->read(raw_size);
+	m_map->read(comp_size);
+	m_map->read(n_events);
+	m_events = m_chunks.back().first_event + n_events;
+      }
+      return;
+    }
+  }
+  EUDAQ_WARN("RawzFileReader: no chunk index in " + m_filename + ", scanning the file");
+  ScanChunks();
+}
+
+void RawzFileReader::ScanChunks(){
+  uint64_t size = m_map->Size();
+  uint64_t pos = eudaq::rawz::HEADER_SIZE;
+  m_events = 0;
+  while(pos + eudaq::rawz::CHUNK_HEADER_SIZE <= size){
+    uint32_t raw_size, comp_size, n_events;
+    m_map->Seek(pos);
+    m_map->read(raw_size);
+    m_map->read(comp_size);
+    m_map->read(n_events);
+    uint64_t end = pos + eudaq::rawz::CHUNK_HEADER_SIZE + comp_size;
+    // a chunk always has events, so this is the index or a truncated chunk
+    if(n_events == 0 || end > size)
+      break;
+    eudaq::rawz::ChunkInfo info;
+    info.offset = pos;
+    info.first_event = m_events;
+    m_chunks.push_back(info);
+    m_events += n_events;
+    pos = end;
+  }
+}
+
+std::future<RawzFileReader::ChunkUP> RawzFileReader::DecodeChunk(size_t c, bool async){
+  uint32_t raw_size, comp_size, n_events;
+  m_map->Seek(m_chunks[c].offset);
+  m_map->read(raw_size);
+  m_map->read(comp_size);
+  m_map->read(n_events);
+  // refers to the mapping, the compressed data is not copied
+  eudaq::DataBlock comp = m_map->ReadBlock(comp_size);
+  return std::async(async ? std::launch::async : std::launch::deferred,
+		    [comp, raw_size](){
+		      std::vector<uint8_t> raw(raw_size);
+		      eudaq::rawz::Decompress(comp.data(), comp.size(), raw.data(), raw_size);
+		      return ChunkUP(new eudaq::BufferSerializer(std::move(raw)));
+		    });
+}
+
+bool RawzFileReader::LoadChunk(size_t c){
+  if(c >= m_chunks.size())
+    return false;
+  std::future<ChunkUP> f;
+  if(m_prefetch.valid() && m_prefetch_chunk == c)
+    f = std::move(m_prefetch);
+  else
+    f = DecodeChunk(c, false);
+  if(m_prefetch.valid())
+    m_prefetch.wait();
+  m_cur = f.get();
+  m_cur_chunk = c;
+  uint64_t next_first = c + 1 < m_chunks.size() ? m_chunks[c + 1].first_event : m_events;
+  m_left = next_first - m_chunks[c].first_event;
+  if(c + 1 < m_chunks.size()){
+    m_prefetch = DecodeChunk(c + 1, true);
+    m_prefetch_chunk = c + 1;
+  }
+  return true;
+}
+
+eudaq::EventSPC RawzFileReader::GetNextEvent(){
+  if(!m_map)
+    Open();
+  if(!m_left){
+    size_t c = m_cur ? m_cur_chunk + 1 : 0;
+    if(!LoadChunk(c))
+      return nullptr;
+  }
+  uint32_t id;
+  m_cur->PreRead(id);
+  eudaq::EventSPC ev = eudaq::Factory<eudaq::Event>::
+    Create<eudaq::Deserializer&>(id, *m_cur);
+  m_left--;
+  return ev;
+}
+
+bool RawzFileReader::Seek(uint32_t i){
+  if(!m_map)
+    Open();
+  if(i >= m_events)
+    return false;
+  m_map->SetSequential(false);
+  auto it = std::upper_bound(m_chunks.begin(), m_chunks.end(), uint64_t(i),
+			     [](uint64_t n, const eudaq::rawz::ChunkInfo &c){
+			       return n < c.first_event;
+			     });
+  size_t c = (it - m_chunks.begin()) - 1;
+  if(!LoadChunk(c))
+    return false;
+  for(uint64_t n = m_chunks[c].first_event; n < i; n++){
+    uint32_t id;
+    m_cur->PreRead(id);
+    eudaq::Factory<eudaq::Event>::Create<eudaq::Deserializer&>(id, *m_cur);
+    m_left--;
+  }
+  return true;
+}
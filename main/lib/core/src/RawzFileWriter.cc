@@ -0,0 +1,125 @@
+#include "eudaq/FileNamer.hh"
+#include "eudaq/FileWriter.hh"
+#include "eudaq/FileSerializer.hh"
+#include "eudaq/BufferSerializer.hh"
+#include "eudaq/RawzFile.hh"
+#include "eudaq/Logger.hh"
+
+class RawzFileWriter : public eudaq::FileWriter {
+public:
+  RawzFileWriter(const std::string &patt);
+  ~RawzFileWriter() override;
+  void WriteEvent(eudaq::EventSPC ev) override;
+  uint64_t FileBytes() const override;
+  std::string FileName() const override {return m_filename;};
+private:
+  void Open(uint32_t run_n);
+  void Close();
+  void WriteChunk();
+  std::unique_ptr<eudaq::FileSerializer> m_ser;
+  eudaq::BufferSerializer m_chunk;
+  uint32_t m_chunk_events;
+  uint64_t m_events;
+  std::vector<eudaq::rawz::ChunkInfo> m_chunks;
+  std::string m_filepattern;
+  std::string m_filename;
+  uint32_t m_run_n;
+  uint64_t m_chunk_bytes;
+  int m_level;
+};
+
+namespace{
+  auto dummy0 = eudaq::Factory<eudaq::FileWriter>::
+    Register<RawzFileWriter, std::string&>(eudaq::cstr2hash("rawz"));
+  auto dummy1 = eudaq::Factory<eudaq::FileWriter>::
+    Register<RawzFileWriter, std::string&&>(eudaq::cstr2hash("rawz"));
+}
+
+RawzFileWriter::RawzFileWriter(const std::string &patt)
+  :m_chunk_events(0), m_events(0), m_filepattern(patt), m_run_n(0),
+   m_chunk_bytes(1 << 20), m_level(1){
+  if(!eudaq::rawz::Available())
+    EUDAQ_THROW("RawzFileWriter: EUDAQ was built without zlib");
+}
+
+RawzFileWriter::~RawzFileWriter(){
+  try{
+    Close();
+  }catch(const eudaq::Exception &e){
+    EUDAQ_ERROR(std::string("RawzFileWriter: ") + e.what());
+  }
+}
+
+void RawzFileWriter::Open(uint32_t run_n){
+  Close();
+  std::time_t time_now = std::time(nullptr);
+  char time_buff[13];
+  time_buff[12] = 0;
+  std::strftime(time_buff, sizeof(time_buff),
+		"%y%m%d%H%M%S", std::localtime(&time_now));
+  std::string time_str(time_buff);
+  auto conf = GetConfiguration();
+  if(conf){
+    m_chunk_bytes = conf->Get("EUDAQ_FW_RAWZ_CHUNK_BYTES", uint64_t(1 << 20));
+    m_level = conf->Get("EUDAQ_FW_RAWZ_LEVEL", 1);
+  }
+  m_filename = eudaq::FileNamer(m_filepattern).
+    Set('X', ".rawz").
+    Set('R', run_n).
+    Set('D', time_str);
+  m_ser.reset(new eudaq::FileSerializer(m_filename));
+  m_ser->write(eudaq::rawz::FILE_MAGIC);
+  m_ser->write(eudaq::rawz::VERSION);
+  m_ser->write(eudaq::rawz::CODEC_ZLIB);
+  m_run_n = run_n;
+}
+
+void RawzFileWriter::WriteChunk(){
+  if(!m_chunk_events)
+    return;
+  auto comp = eudaq::rawz::Compress(&m_chunk[0], m_chunk.size(), m_level);
+  eudaq::rawz::ChunkInfo info;
+  info.offset = m_ser->FileBytes();
+  info.first_event = m_events;
+  m_chunks.push_back(info);
+  m_ser->write(uint32_t(m_chunk.size()));
+  m_ser->write(uint32_t(comp.size()));
+  m_ser->write(m_chunk_events);
+  m_ser->append(comp.data(), comp.size());
+  m_ser->Flush();
+  m_events += m_chunk_events;
+  m_chunk_events = 0;
+  m_chunk.clear();
+}
+
+void RawzFileWriter::Close(){
+  if(!m_ser)
+    return;
+  WriteChunk();
+  uint64_t index_offset = m_ser->FileBytes();
+  m_ser->write(uint32_t(m_chunks.size()));
+  for(auto &c: m_chunks){
+    m_ser->write(c.offset);
+    m_ser->write(c.first_event);
+  }
+  m_ser->write(index_offset);
+  m_ser->write(eudaq::rawz::INDEX_MAGIC);
+  m_ser->Flush();
+  m_ser.reset();
+  m_chunks.clear();
+  m_events = 0;
+}
+
+void RawzFileWriter::WriteEvent(eudaq::EventSPC ev) {
+  uint32_t run_n = ev->GetRunN();
+  if(!m_ser || m_run_n != run_n)
+    Open(run_n);
+  m_chunk.write(*ev);
+  m_chunk_events++;
+  if(m_chunk.size() >= m_chunk_bytes || ev->IsEORE())
+    WriteChunk();
+}
+
+uint64_t RawzFileWriter::FileBytes() const {
+  return m_ser ?m_ser->FileBytes() :0;
+}
@@ -11,10 +11,6 @@ namespace eudaq{
     t.Serialize(*this);
   }
 
-  void Serializer::append(const uint8_t *data, size_t size) {
-    Serialize(data, size);
-  }
-
   uint64_t Serializer::GetCheckSum(){
     return 0;
   }
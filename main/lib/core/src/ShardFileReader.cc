@@ -0,0 +1,86 @@
+#include "eudaq/FileReader.hh"
+#include "eudaq/ShardIndex.hh"
+
+#include <fstream>
+
+// Reads a run written by the "shards" FileWriter, given its .shards index,
+// and returns the events of all the shards in their original order.
+class ShardFileReader : public eudaq::FileReader {
+public:
+  ShardFileReader(const std::string& filename);
+  eudaq::EventSPC GetNextEvent() override;
+  bool Seek(uint32_t i) override;
+private:
+  eudaq::FileReader &Shard(uint32_t s);
+  std::string m_filename;
+  eudaq::ShardIndexSP m_index;
+  std::vector<eudaq::FileReaderUP> m_readers; // opened on first use
+  std::vector<uint32_t> m_pos; // next event of each shard to be returned
+  std::vector<uint32_t> m_at; // next event each reader returns by itself
+  uint32_t m_next;
+};
+
+namespace{
+  auto dummy0 = eudaq::Factory<eudaq::FileReader>::
+    Register<ShardFileReader, std::string&>(eudaq::cstr2hash("shards"));
+  auto dummy1 = eudaq::Factory<eudaq::FileReader>::
+    Register<ShardFileReader, std::string&&>(eudaq::cstr2hash("shards"));
+}
+
+ShardFileReader::ShardFileReader(const std::string& filename)
+  :m_filename(filename), m_next(0){
+  m_index = eudaq::ShardIndex::Load(filename);
+  uint32_t n = m_index->GetShardN();
+  m_readers.resize(n);
+  m_pos.assign(n, 0);
+  m_at.assign(n, 0);
+}
+
+eudaq::FileReader &ShardFileReader::Shard(uint32_t s){
+  if(!m_readers[s]){
+    std::string path = m_index->GetPath(s);
+    if(!std::ifstream(path)){
+      // the shards were moved together with their index
+      size_t dir = m_filename.find_last_of("/\\");
+      size_t base = path.find_last_of("/\\");
+      path = (dir == std::string::npos ?"" :m_filename.substr(0, dir + 1)) +
+	(base == std::string::npos ?path :path.substr(base + 1));
+    }
+    std::string type = m_index->GetType();
+    m_readers[s] = eudaq::Factory<eudaq::FileReader>::MakeUnique<std::string&>(eudaq::str2hash(type), path);
+    if(!m_readers[s])
+      EUDAQ_THROW("ShardFileReader: No FileReader of type '" + type + "' for " + path);
+    m_readers[s]->SetConfiguration(GetConfiguration());
+  }
+  if(m_at[s] != m_pos[s]){
+    if(!m_readers[s]->Seek(m_pos[s]))
+      EUDAQ_THROW("ShardFileReader: Cannot seek to event " + std::to_string(m_pos[s]) +
+		  " of shard " + std::to_string(s));
+    m_at[s] = m_pos[s];
+  }
+  return *m_readers[s];
+}
+
+eudaq::EventSPC ShardFileReader::GetNextEvent(){
+  if(m_next >= m_index->Size())
+    return nullptr;
+  uint32_t s = m_index->At(m_next);
+  auto ev = Shard(s).GetNextEvent();
+  if(!ev)
+    EUDAQ_THROW("ShardFileReader: Shard " + std::to_string(s) + " ends before event "
+		+ std::to_string(m_next));
+  m_at[s]++;
+  m_pos[s]++;
+  m_next++;
+  return ev;
+}
+
+bool ShardFileReader::Seek(uint32_t i){
+  if(i > m_index->Size())
+    return false;
+  std::fill(m_pos.begin(), m_pos.end(), 0);
+  for(uint32_t j = 0; j < i; j++)
+    m_pos[m_index->At(j)]++;
+  m_next = i;
+  return true;
+}
@@ -0,0 +1,250 @@
+#include "eudaq/FileNamer.hh"
+#include "eudaq/FileWriter.hh"
+#include "eudaq/ShardIndex.hh"
+#include "eudaq/LockFreeQueue.hh"
+#include "eudaq/Logger.hh"
+
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <ctime>
+
+// Writes the events of a run to several files in parallel, each by its own
+// inner writer (EUDAQ_FW) on its own thread. The shard of an event is chosen
+// round-robin or by ranges of EUDAQ_FW_SHARD_TRIGGERS trigger numbers. The
+// order of the events is recorded in a ShardIndex, which the "shards"
+// FileReader uses to read them back in sequence. The index is rewritten
+// every EUDAQ_FW_SHARD_INDEX_EVENTS events and at the end of the run, so
+// a run that is cut short can still be read up to the last rewrite.
+class ShardFileWriter : public eudaq::FileWriter {
+public:
+  ShardFileWriter(const std::string &patt);
+  ~ShardFileWriter() override;
+  void WriteEvent(eudaq::EventSPC ev) override;
+  uint64_t FileBytes() const override;
+  std::string FileName() const override {return m_filename;};
+private:
+  struct Shard {
+    Shard(size_t depth) :que(depth), bytes(0), busy(0) {};
+    eudaq::FileWriterSP writer;
+    eudaq::LockFreeQueue<eudaq::EventSPC> que;
+    std::thread th;
+    std::atomic<uint64_t> bytes;
+    std::atomic<uint32_t> busy; // queued or being written
+    std::string path;
+  };
+
+  void Open(uint32_t run_n);
+  void Close();
+  void Drain();
+  void Save();
+  void Writing(Shard *sh, uint32_t i);
+  void CheckError();
+  static std::string ShardPattern(const std::string &patt, uint32_t i);
+
+  std::vector<std::unique_ptr<Shard>> m_shards;
+  eudaq::ShardIndex m_index;
+  std::string m_filepattern;
+  std::string m_filename;
+  uint32_t m_run_n;
+  bool m_by_trigger;
+  uint32_t m_trg_range;
+  uint64_t m_next;
+  size_t m_saved_n;
+  size_t m_save_every;
+  std::atomic<bool> m_failed;
+  std::string m_error;
+  std::mutex m_mtx;
+  std::condition_variable m_cv_idle;
+};
+
+namespace{
+  auto dummy0 = eudaq::Factory<eudaq::FileWriter>::
+    Register<ShardFileWriter, std::string&>(eudaq::cstr2hash("shards"));
+  auto dummy1 = eudaq::Factory<eudaq::FileWriter>::
+    Register<ShardFileWriter, std::string&&>(eudaq::cstr2hash("shards"));
+}
+
+ShardFileWriter::ShardFileWriter(const std::string &patt)
+  :m_filepattern(patt), m_run_n(0), m_by_trigger(false), m_trg_range(1),
+   m_next(0), m_saved_n(0), m_save_every(0), m_failed(false){
+}
+
+ShardFileWriter::~ShardFileWriter(){
+  try{
+    Close();
+  }catch(const eudaq::Exception &e){
+    EUDAQ_ERROR(std::string("ShardFileWriter: ") + e.what());
+  }
+}
+
+std::string ShardFileWriter::ShardPattern(const std::string &patt, uint32_t i){
+  std::string tag = "_s" + std::to_string(i);
+  size_t pos = patt.rfind("$X");
+  if(pos == std::string::npos)
+    return patt + tag;
+  return patt.substr(0, pos) + tag + patt.substr(pos);
+}
+
+void ShardFileWriter::Open(uint32_t run_n){
+  Close();
+  auto conf = GetConfiguration();
+  if(!conf)
+    EUDAQ_THROW("ShardFileWriter: No configuration");
+  std::string type = conf->Get("EUDAQ_FW", "native");
+  if(type == "shards")
+    EUDAQ_THROW("ShardFileWriter: EUDAQ_FW must name the writer of the shards");
+  uint32_t n = conf->Get("EUDAQ_FW_SHARDS", 2);
+  if(n < 1 || n > eudaq::ShardIndex::MAX_SHARDS)
+    EUDAQ_THROW("ShardFileWriter: EUDAQ_FW_SHARDS must be between 1 and "
+		+ std::to_string(eudaq::ShardIndex::MAX_SHARDS));
+  std::string mode = conf->Get("EUDAQ_FW_SHARD_MODE", "roundrobin");
+  if(mode == "trigger")
+    m_by_trigger = true;
+  else if(mode == "roundrobin")
+    m_by_trigger = false;
+  else
+    EUDAQ_THROW("ShardFileWriter: Unknown EUDAQ_FW_SHARD_MODE '" + mode + "'");
+  m_trg_range = conf->Get("EUDAQ_FW_SHARD_TRIGGERS", 1000);
+  if(!m_trg_range)
+    m_trg_range = 1;
+  size_t depth = conf->Get("EUDAQ_FW_SHARD_QUEUE", 1024);
+  m_save_every = conf->Get("EUDAQ_FW_SHARD_INDEX_EVENTS", 10000);
+
+  std::time_t time_now = std::time(nullptr);
+  char time_buff[13];
+  time_buff[12] = 0;
+  std::strftime(time_buff, sizeof(time_buff),
+		"%y%m%d%H%M%S", std::localtime(&time_now));
+  std::string time_str(time_buff);
+  m_filename = eudaq::FileNamer(m_filepattern).
+    Set('X', ".shards").
+    Set('R', run_n).
+    Set('D', time_str);
+
+  m_index = eudaq::ShardIndex(type);
+  m_index.SetShardN(n);
+  m_failed = false;
+  m_error.clear();
+  m_next = 0;
+  m_saved_n = 0;
+  for(uint32_t i = 0; i < n; i++){
+    std::string patt = conf->Get("EUDAQ_FW_PATTERN_" + std::to_string(i),
+				 ShardPattern(m_filepattern, i));
+    std::unique_ptr<Shard> sh(new Shard(depth));
+    sh->writer = eudaq::Factory<eudaq::FileWriter>::Create<std::string&>(eudaq::str2hash(type), patt);
+    if(!sh->writer){
+      Close();
+      EUDAQ_THROW("ShardFileWriter: Unknown FileWriter type '" + type + "'");
+    }
+    sh->writer->SetConfiguration(conf);
+    sh->th = std::thread(&ShardFileWriter::Writing, this, sh.get(), i);
+    m_shards.push_back(std::move(sh));
+  }
+  m_run_n = run_n;
+}
+
+void ShardFileWriter::Writing(Shard *sh, uint32_t i){
+  eudaq::EventSPC ev;
+  for(;;){
+    if(!sh->que.Pop(ev, std::chrono::milliseconds(100))){
+      if(sh->que.IsClosed() && sh->que.Empty())
+	break;
+      continue;
+    }
+    if(!m_failed){
+      try{
+	sh->writer->WriteEvent(ev);
+	sh->bytes = sh->writer->FileBytes();
+	// the index can only point to a file whose name the writer reports
+	std::string path = sh->writer->FileName();
+	if(path.empty())
+	  EUDAQ_THROW("the FileWriter of EUDAQ_FW does not report its file name,"
+		      " it can not write shards");
+	sh->path = path;
+      }catch(const std::exception &e){
+	std::unique_lock<std::mutex> lk(m_mtx);
+	if(!m_failed)
+	  m_error = "shard " + std::to_string(i) + ": " + e.what();
+	m_failed = true;
+      }
+    }
+    ev.reset();
+    if(sh->busy.fetch_sub(1) == 1 || m_failed){
+      std::unique_lock<std::mutex> lk(m_mtx);
+      m_cv_idle.notify_all();
+    }
+  }
+}
+
+void ShardFileWriter::CheckError(){
+  if(m_failed){
+    std::unique_lock<std::mutex> lk(m_mtx);
+    EUDAQ_THROW("ShardFileWriter: " + m_error);
+  }
+}
+
+void ShardFileWriter::Drain(){
+  std::unique_lock<std::mutex> lk(m_mtx);
+  m_cv_idle.wait(lk, [this](){
+      if(m_failed)
+	return true;
+      for(auto &sh: m_shards)
+	if(sh->busy)
+	  return false;
+      return true;
+    });
+}
+
+void ShardFileWriter::Save(){
+  if(m_shards.empty() || m_saved_n == m_index.Size())
+    return;
+  Drain();
+  if(m_failed) // the shards miss events listed in the index
+    return;
+  for(uint32_t i = 0; i < m_shards.size(); i++)
+    m_index.SetPath(i, m_shards[i]->path);
+  m_index.Save(m_filename);
+  m_saved_n = m_index.Size();
+}
+
+void ShardFileWriter::Close(){
+  if(m_shards.empty())
+    return;
+  for(auto &sh: m_shards)
+    sh->que.Close();
+  for(auto &sh: m_shards)
+    if(sh->th.joinable())
+      sh->th.join();
+  Save();
+  m_shards.clear();
+}
+
+void ShardFileWriter::WriteEvent(eudaq::EventSPC ev) {
+  uint32_t run_n = ev->GetRunN();
+  if(m_shards.empty() || m_run_n != run_n)
+    Open(run_n);
+  CheckError();
+  uint32_t s;
+  if(m_by_trigger)
+    s = (ev->GetTriggerN() / m_trg_range) % m_shards.size();
+  else
+    s = m_next++ % m_shards.size();
+  Shard &sh = *m_shards[s];
+  m_index.Add(s);
+  bool eore = ev->IsEORE();
+  sh.busy++;
+  sh.que.Push(std::move(ev));
+  if(eore || (m_save_every && m_index.Size() - m_saved_n >= m_save_every)){
+    Save();
+    CheckError();
+  }
+}
+
+uint64_t ShardFileWriter::FileBytes() const {
+  uint64_t bytes = 0;
+  for(auto &sh: m_shards)
+    bytes += sh->bytes;
+  return bytes;
+}
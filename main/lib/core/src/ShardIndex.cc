@@ -0,0 +1,53 @@
+#include "eudaq/ShardIndex.hh"
+#include "eudaq/FileSerializer.hh"
+#include "eudaq/FileDeserializer.hh"
+#include "eudaq/Exception.hh"
+#include "eudaq/Utils.hh"
+
+namespace eudaq {
+  namespace {
+    const uint32_t SHARD_MAGIC = cstr2hash("EUDAQSHD");
+    const uint32_t SHARD_VERSION = 1;
+  }
+
+  void ShardIndex::SetShardN(uint32_t n){
+    if(n > MAX_SHARDS)
+      EUDAQ_THROW("ShardIndex: At most " + std::to_string(MAX_SHARDS) + " shards are supported");
+    m_paths.resize(n);
+  }
+
+  void ShardIndex::SetPath(uint32_t shard, const std::string &path){
+    m_paths.at(shard) = path;
+  }
+
+  void ShardIndex::Save(const std::string &path) const{
+    FileSerializer ser(path, true);
+    ser.write(SHARD_MAGIC);
+    ser.write(SHARD_VERSION);
+    ser.write(m_type);
+    ser.write(m_paths);
+    ser.write(m_seq);
+    ser.Flush();
+  }
+
+  ShardIndexSP ShardIndex::Load(const std::string &path){
+    ShardIndexSP idx(new ShardIndex);
+    FileDeserializer des(path, true);
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    try{
+      des.read(magic);
+      des.read(version);
+    }catch(const FileReadException &){
+    }
+    if(magic != SHARD_MAGIC || version != SHARD_VERSION)
+      EUDAQ_THROWX(FileFormatException, "Not a shard index file: " + path);
+    des.read(idx->m_type);
+    des.read(idx->m_paths);
+    des.read(idx->m_seq);
+    for(auto s: idx->m_seq)
+      if(s >= idx->m_paths.size())
+	EUDAQ_THROWX(FileFormatException, "Corrupted shard index file: " + path);
+    return idx;
+  }
+}
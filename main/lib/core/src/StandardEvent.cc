@@ -26,9 +26,18 @@ namespace eudaq {
 
   void StandardEvent::Serialize(Serializer &ser) const {
     Event::Serialize(ser);
-    ser.write(m_planes);
+    if(!IsFlagCompact()){
+      ser.write(m_planes);
+      return;
+    }
+    ser.write((uint32_t)m_planes.size());
+    for(auto &plane: m_planes)
+      plane.SerializeCompact(ser);
   }
 
+  void StandardEvent::SetFlagCompact(){SetFlagBit(FLAG_COMP);}
+  bool StandardEvent::IsFlagCompact() const {return IsFlagBit(FLAG_COMP);}
+
   void StandardEvent::Print(std::ostream & os, size_t offset) const{
     os << std::string(offset, ' ') << "<StandardEvent>\n";
     if(!m_planes.empty()){
@@ -55,4 +64,9 @@ namespace eudaq {
     m_planes.push_back(plane);
     return m_planes.back();
   }
+
+  StandardPlane &StandardEvent::AddPlane(StandardPlane &&plane) {
+    m_planes.push_back(std::move(plane));
+    return m_planes.back();
+  }
 }
@@ -1,6 +1,13 @@
 #include "eudaq/StandardPlane.hh"
+#include "eudaq/CompactPlane.hh"
 
 namespace eudaq{
+  namespace{
+    // written in place of the length of the type string, which it can not
+    // be, when the plane is serialized as a CompactPlane
+    const uint32_t compact_tag = 0xFFFFFFFF;
+  }
+
   StandardPlane::StandardPlane()
     : m_id(0), m_xsize(0), m_ysize(0), m_flags(0),
       m_pivotpixel(0), m_result_pix(0), m_result_x(0), m_result_y(0) {}
@@ -13,6 +20,13 @@ namespace eudaq{
 
   StandardPlane::StandardPlane(Deserializer &ds)
     : m_result_pix(0), m_result_x(0), m_result_y(0) {
+    uint32_t tag;
+    ds.PreRead(tag);
+    if(tag == compact_tag){
+      ds.read(tag);
+      CompactPlane(ds).Unpack(*this);
+      return;
+    }
     ds.read(m_type);
     ds.read(m_sensor);
     ds.read(m_id);
@@ -25,6 +39,18 @@ namespace eudaq{
     ds.read(m_y);
     ds.read(m_pivot);
     ds.read(m_mat);
+    if(m_flags & FLAG_WITHTIME)
+      ds.read(m_time);
+  }
+
+  void StandardPlane::SerializeCompact(Serializer &ser) const {
+    // integer hits are sent in a fraction of the size
+    if(CompactPlane::Fits(*this)){
+      ser.write(compact_tag);
+      CompactPlane(*this).Serialize(ser);
+      return;
+    }
+    Serialize(ser);
   }
 
   void StandardPlane::Serialize(Serializer &ser) const {
@@ -40,6 +66,8 @@ namespace eudaq{
     ser.write(m_y);
     ser.write(m_pivot);
     ser.write(m_mat);
+    if(m_flags & FLAG_WITHTIME)
+      ser.write(m_time);
   }
 
 
@@ -71,6 +99,7 @@ namespace eudaq{
     m_pivot.resize(GetFlags(FLAG_WITHPIVOT)
 		   ? (GetFlags(FLAG_DIFFCOORDS) ? frames : 1)
 		   : 0);
+    m_time.resize(GetFlags(FLAG_WITHTIME) ? m_x.size() : 0);
     for (size_t i = 0; i < frames; ++i) {
       m_pix[i].resize(npix);
     }
@@ -79,6 +108,8 @@ namespace eudaq{
       m_y[i].resize(npix);
       if (m_pivot.size())
 	m_pivot[i].resize(npix);
+      if (m_time.size())
+	m_time[i].resize(npix);
     }
   }
 
@@ -91,10 +122,32 @@ namespace eudaq{
     m_pix[frame].push_back(p);
     if (m_pivot.size())
       m_pivot[frame].push_back(pivot);
+    if (m_time.size())
+      m_time[frame].push_back(0);
     // std::cout << "DBG: " << frame << ", " << x << ", " << y << ", " << p <<
     // ";" << m_pix[0].size() << ", " << m_pivot.size() << std::endl;
   }
 
+  void StandardPlane::PushPixels(uint32_t frame, const uint16_t *x,
+				 const uint16_t *y, uint32_t n,
+				 const uint8_t *pivot) {
+    if (frame >= m_pix.size())
+      EUDAQ_THROW("Bad frame number " + to_string(frame) + " in PushPixels");
+    m_pix[frame].insert(m_pix[frame].end(), n, 1);
+    if (frame < m_x.size()) {
+      m_x[frame].insert(m_x[frame].end(), x, x + n);
+      m_y[frame].insert(m_y[frame].end(), y, y + n);
+    }
+    if (frame < m_pivot.size()) {
+      if (pivot)
+	m_pivot[frame].insert(m_pivot[frame].end(), pivot, pivot + n);
+      else
+	m_pivot[frame].resize(m_pivot[frame].size() + n, false);
+    }
+    if (frame < m_time.size())
+      m_time[frame].resize(m_time[frame].size() + n, 0);
+  }
+
   void StandardPlane::SetPixelHelper(uint32_t index, uint32_t x, uint32_t y,
 				     double pix, bool pivot, uint32_t frame) {
     if (frame >= m_pix.size())
@@ -145,6 +198,18 @@ namespace eudaq{
     m_pivot.at(frame).at(index) = PivotFlag;
   }
 
+  uint64_t StandardPlane::GetTime(uint32_t index, uint32_t frame) const {
+    if (m_time.empty())
+      return 0;
+    if (!GetFlags(FLAG_DIFFCOORDS))
+      frame = 0;
+    return m_time.at(frame).at(index);
+  }
+
+  void StandardPlane::SetTime(uint32_t index, uint64_t time, uint32_t frame) {
+    m_time.at(frame).at(index) = time;
+  }
+
   const std::vector<StandardPlane::coord_t> &
   StandardPlane::XVector(uint32_t frame) const {
     return GetFrame(m_x, frame);
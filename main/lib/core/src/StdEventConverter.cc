@@ -1,4 +1,5 @@
 #include "eudaq/StdEventConverter.hh"
+#include "eudaq/ConverterRegistry.hh"
 
 namespace eudaq{
 
@@ -42,7 +43,7 @@ namespace eudaq{
       d2->SetDescription(d1->GetDescription());
     }
     uint32_t id = d1->GetType();
-    auto cvt = Factory<StdEventConverter>::MakeUnique(id);
+    auto cvt = ConverterRegistry<StdEventConverter>::Get(id, conf);
     if(cvt){
       return cvt->Converting(d1, d2, conf);
     }
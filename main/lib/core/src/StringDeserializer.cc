@@ -0,0 +1,44 @@
+#include "eudaq/StringDeserializer.hh"
+#include "eudaq/Utils.hh"
+#include <cstring>
+
+namespace eudaq {
+
+  StringDeserializer::StringDeserializer(std::string &&data)
+    : m_data(std::make_shared<const std::string>(std::move(data))) {
+    m_rd_data = reinterpret_cast<const uint8_t *>(m_data->data());
+    m_rd_size = m_data->size();
+  }
+
+  const uint8_t *StringDeserializer::At() const {
+    return reinterpret_cast<const uint8_t *>(m_data->data()) + m_rd_pos;
+  }
+
+  void StringDeserializer::CheckAvailable(size_t len) const {
+    if (len > m_data->size() - m_rd_pos)
+      EUDAQ_THROW("Deserialize asked for " + to_string(len) + ", only have " +
+		  to_string(m_data->size() - m_rd_pos));
+  }
+
+  void StringDeserializer::Deserialize(uint8_t *data, size_t len) {
+    if (!len)
+      return;
+    CheckAvailable(len);
+    std::memcpy(data, At(), len);
+    m_rd_pos += len;
+  }
+
+  void StringDeserializer::PreDeserialize(uint8_t *data, size_t len) {
+    if (!len)
+      return;
+    CheckAvailable(len);
+    std::memcpy(data, At(), len);
+  }
+
+  DataBlock StringDeserializer::DeserializeBlock(size_t len) {
+    CheckAvailable(len);
+    DataBlock block(std::shared_ptr<const uint8_t>(m_data, At()), len);
+    m_rd_pos += len;
+    return block;
+  }
+}
@@ -0,0 +1,128 @@
+#include "eudaq/TaskExecutor.hh"
+#include "eudaq/Logger.hh"
+
+#include <cstdlib>
+
+namespace eudaq {
+  namespace {
+    // the executor and index of the worker running on this thread
+    thread_local TaskExecutor *tl_executor = nullptr;
+    thread_local uint32_t tl_worker = 0;
+  }
+
+  TaskExecutor::TaskExecutor(uint32_t n_threads)
+    :m_n_queued(0), m_n_idle(0), m_n_stolen(0), m_stop(false){
+    if(!n_threads)
+      n_threads = std::thread::hardware_concurrency();
+    if(!n_threads)
+      n_threads = 1;
+    for(uint32_t i = 0; i < n_threads; i++)
+      m_workers.emplace_back(new Worker);
+    for(uint32_t i = 0; i < n_threads; i++)
+      m_workers[i]->th = std::thread(&TaskExecutor::Working, this, i);
+  }
+
+  TaskExecutor::~TaskExecutor(){
+    {
+      std::unique_lock<std::mutex> lk(m_mtx);
+      m_stop = true;
+      m_cv.notify_all();
+    }
+    for(auto &w: m_workers)
+      if(w->th.joinable())
+	w->th.join();
+  }
+
+  TaskExecutor &TaskExecutor::Instance(){
+    static TaskExecutor ex([](){
+	char *env_n = std::getenv("EUDAQ_EXECUTOR_THREADS");
+	return env_n ?uint32_t(std::strtoul(env_n, nullptr, 10)) :0;
+      }());
+    return ex;
+  }
+
+  bool TaskExecutor::IsWorkerThread() const{
+    return tl_executor == this;
+  }
+
+  void TaskExecutor::Submit(Task t){
+    m_n_queued++;
+    if(tl_executor == this){
+      Worker &w = *m_workers[tl_worker];
+      std::unique_lock<std::mutex> lk(w.mtx);
+      w.que.push_back(std::move(t));
+    }
+    else{
+      std::unique_lock<std::mutex> lk(m_mtx);
+      m_que.push_back(std::move(t));
+    }
+    if(m_n_idle){
+      std::unique_lock<std::mutex> lk(m_mtx);
+      m_cv.notify_one();
+    }
+  }
+
+  bool TaskExecutor::Take(uint32_t i, Task &t){
+    {
+      Worker &w = *m_workers[i];
+      std::unique_lock<std::mutex> lk(w.mtx);
+      if(!w.que.empty()){
+	t = std::move(w.que.back());
+	w.que.pop_back();
+	m_n_queued--;
+	return true;
+      }
+    }
+    {
+      std::unique_lock<std::mutex> lk(m_mtx);
+      if(!m_que.empty()){
+	t = std::move(m_que.front());
+	m_que.pop_front();
+	m_n_queued--;
+	return true;
+      }
+    }
+    size_t n = m_workers.size();
+    for(size_t k = 1; k < n; k++){
+      Worker &v = *m_workers[(i + k) % n];
+      std::unique_lock<std::mutex> lk(v.mtx);
+      if(!v.que.empty()){
+	t = std::move(v.que.front());
+	v.que.pop_front();
+	m_n_queued--;
+	m_n_stolen++;
+	return true;
+      }
+    }
+    return false;
+  }
+
+  void TaskExecutor::Working(uint32_t i){
+    tl_executor = this;
+    tl_worker = i;
+    Task t;
+    for(;;){
+      if(Take(i, t)){
+	// a failing task must not take the worker, and the tasks queued on
+	// it, down with it
+	try{
+	  t();
+	}catch(const std::exception &e){
+	  EUDAQ_ERROR(std::string("TaskExecutor:: Task failed: ") + e.what());
+	}catch(...){
+	  EUDAQ_ERROR("TaskExecutor:: Task failed with an unknown exception");
+	}
+	t = nullptr;
+	continue;
+      }
+      std::unique_lock<std::mutex> lk(m_mtx);
+      // a Submit either sees the idle count or leaves m_n_queued raised
+      m_n_idle++;
+      m_cv.wait(lk, [this](){return m_stop || m_n_queued;});
+      m_n_idle--;
+      if(m_stop && !m_n_queued)
+	break;
+    }
+    tl_executor = nullptr;
+  }
+}
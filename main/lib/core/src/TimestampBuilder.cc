@@ -0,0 +1,249 @@
+#include "eudaq/TimestampBuilder.hh"
+#include "eudaq/Exception.hh"
+
+#include <algorithm>
+#include <limits>
+
+namespace eudaq {
+  namespace{
+    const uint64_t TS_MAX = std::numeric_limits<uint64_t>::max();
+
+    uint64_t AddSat(uint64_t a, uint64_t b){
+      return a > TS_MAX - b ? TS_MAX : a + b;
+    }
+
+    uint64_t Shift(uint64_t t, int64_t offset){
+      if(offset >= 0)
+	return AddSat(t, offset);
+      uint64_t d = uint64_t(-(offset + 1)) + 1;
+      return t > d ? t - d : 0;
+    }
+  }
+
+  TimestampBuilder::TimestampBuilder()
+    :m_cur_begin(0), m_cur_end(0), m_cur_reach(0), m_cur_limit(0), m_last_reach(0),
+     m_n_streams(0), m_n_pending(0), m_window(0), m_max_delay(0), m_max_span(0),
+     m_idle(0), m_n_built(0),
+     m_n_late(0), m_max_lateness(0){
+  }
+
+  void TimestampBuilder::Configure(uint64_t window, uint64_t max_delay, uint32_t idle_ms,
+				   uint64_t max_span){
+    m_window = window;
+    m_max_delay = max_delay;
+    m_max_span = max_span;
+    m_idle = std::chrono::milliseconds(idle_ms);
+  }
+
+  uint32_t TimestampBuilder::AddStream(const std::string &name, int64_t offset){
+    uint32_t id;
+    if(m_free.empty()){
+      id = m_streams.size();
+      m_streams.emplace_back();
+    }
+    else{
+      id = m_free.back();
+      m_free.pop_back();
+    }
+    auto &s = m_streams[id];
+    s.name = name;
+    s.offset = offset;
+    s.max_begin = 0;
+    s.has_data = false;
+    s.listed = false;
+    s.used = true;
+    s.active = true;
+    s.t_last = Clock::now();
+    s.mark = 0; // nothing can be built before the stream sent something
+    m_n_streams++;
+    List(id);
+    return id;
+  }
+
+  void TimestampBuilder::SetOffset(uint32_t id, int64_t offset){
+    if(id < m_streams.size() && m_streams[id].used)
+      m_streams[id].offset = offset;
+  }
+
+  void TimestampBuilder::RemoveStream(uint32_t id){
+    if(id >= m_streams.size() || !m_streams[id].used || !m_streams[id].active)
+      return;
+    m_streams[id].active = false;
+    Unlist(id);
+    if(m_streams[id].que.empty())
+      Release(id);
+  }
+
+  void TimestampBuilder::Release(uint32_t id){
+    auto &s = m_streams[id];
+    Unlist(id);
+    m_n_pending -= s.que.size();
+    s.que.clear();
+    s.name.clear();
+    s.used = false;
+    m_free.push_back(id);
+    m_n_streams--;
+  }
+
+  void TimestampBuilder::List(uint32_t id){
+    auto &s = m_streams[id];
+    if(s.listed)
+      m_marks.erase(std::make_pair(s.listed_mark, id));
+    s.listed_mark = s.mark;
+    s.listed = true;
+    m_marks.emplace(s.mark, id);
+  }
+
+  void TimestampBuilder::Unlist(uint32_t id){
+    auto &s = m_streams[id];
+    if(!s.listed)
+      return;
+    m_marks.erase(std::make_pair(s.listed_mark, id));
+    s.listed = false;
+  }
+
+  bool TimestampBuilder::Push(uint32_t id, uint64_t begin, uint64_t end, EventSPC ev){
+    if(id >= m_streams.size() || !m_streams[id].used || !m_streams[id].active)
+      EUDAQ_THROW("TimestampBuilder: Push to an unknown stream");
+    auto &s = m_streams[id];
+    begin = Shift(begin, s.offset);
+    end = std::max(begin, Shift(end, s.offset));
+    if(m_idle.count())
+      s.t_last = Clock::now();
+    if(begin < m_last_reach){
+      m_n_late++;
+      m_max_lateness = std::max(m_max_lateness, m_last_reach - begin);
+      return false;
+    }
+    if(!s.has_data || begin > s.max_begin){
+      s.max_begin = begin;
+      s.has_data = true;
+    }
+    s.mark = s.max_begin > m_max_delay ? s.max_begin - m_max_delay : 0;
+    if(!s.listed)
+      List(id);
+    bool front;
+    if(s.que.empty() || begin >= s.que.back().begin){
+      front = s.que.empty();
+      s.que.push_back(Frag{begin, end, std::move(ev)});
+    }
+    else{
+      // reordered, usually close to the back
+      auto it = std::upper_bound(s.que.begin(), s.que.end(), begin,
+				 [](uint64_t b, const Frag &f){return b < f.begin;});
+      front = it == s.que.begin();
+      s.que.insert(it, Frag{begin, end, std::move(ev)});
+    }
+    if(front){
+      m_heap.emplace_back(begin, id);
+      std::push_heap(m_heap.begin(), m_heap.end(), std::greater<Head>());
+    }
+    m_n_pending++;
+    return true;
+  }
+
+  uint64_t TimestampBuilder::GetWatermark(){
+    // The listed marks only ever lag behind, so the lowest one is exact once
+    // it is up to date. Only the streams reaching the top are updated.
+    auto now = m_idle.count() ? Clock::now() : Clock::time_point();
+    while(!m_marks.empty()){
+      uint32_t id = m_marks.begin()->second;
+      auto &s = m_streams[id];
+      if(m_idle.count() && now - s.t_last >= m_idle)
+	Unlist(id); // listed again by its next fragment
+      else if(s.listed_mark != s.mark)
+	List(id);
+      else
+	return s.mark;
+    }
+    return TS_MAX;
+  }
+
+  bool TimestampBuilder::TopHead(Head &head){
+    while(!m_heap.empty()){
+      head = m_heap.front();
+      auto &s = m_streams[head.second];
+      if(s.used && !s.que.empty() && s.que.front().begin == head.first)
+	return true;
+      std::pop_heap(m_heap.begin(), m_heap.end(), std::greater<Head>());
+      m_heap.pop_back();
+    }
+    return false;
+  }
+
+  TimestampBuilder::Frag TimestampBuilder::PopHead(uint32_t id){
+    std::pop_heap(m_heap.begin(), m_heap.end(), std::greater<Head>());
+    m_heap.pop_back();
+    auto &s = m_streams[id];
+    Frag f = std::move(s.que.front());
+    s.que.pop_front();
+    m_n_pending--;
+    if(!s.que.empty()){
+      m_heap.emplace_back(s.que.front().begin, id);
+      std::push_heap(m_heap.begin(), m_heap.end(), std::greater<Head>());
+    }
+    else if(!s.active)
+      Release(id);
+    return f;
+  }
+
+  bool TimestampBuilder::Next(Built &out){
+    uint64_t mark = GetWatermark();
+    Head head;
+    if(m_cur.empty()){
+      if(!TopHead(head) || head.first >= mark)
+	return false;
+      m_cur.push_back(PopHead(head.second));
+      m_cur_begin = m_cur.back().begin;
+      m_cur_end = m_cur.back().end;
+      m_cur_reach = AddSat(m_cur_end, m_window);
+      m_cur_limit = m_max_span ? AddSat(m_cur_begin, m_max_span) : m_cur_reach;
+      m_cur_reach = std::min(m_cur_reach, m_cur_limit);
+    }
+    while(TopHead(head) && head.first < m_cur_reach){
+      m_cur.push_back(PopHead(head.second));
+      auto &f = m_cur.back();
+      m_cur_begin = std::min(m_cur_begin, f.begin);
+      m_cur_end = std::max(m_cur_end, f.end);
+      m_cur_reach = std::min(std::max(m_cur_reach, AddSat(f.end, m_window)), m_cur_limit);
+    }
+    if(m_cur_reach > mark)
+      return false;
+    std::stable_sort(m_cur.begin(), m_cur.end(),
+		     [](const Frag &a, const Frag &b){return a.begin < b.begin;});
+    out.begin = m_cur_begin;
+    out.end = m_cur_end;
+    out.frags.clear();
+    for(auto &f: m_cur)
+      out.frags.push_back(std::move(f.ev));
+    m_cur.clear();
+    m_last_reach = m_cur_reach;
+    m_n_built++;
+    return true;
+  }
+
+  void TimestampBuilder::Clear(){
+    for(uint32_t id = 0; id < m_streams.size(); id++){
+      auto &s = m_streams[id];
+      if(!s.used)
+	continue;
+      if(!s.active){
+	Release(id);
+	continue;
+      }
+      s.que.clear();
+      s.max_begin = 0;
+      s.has_data = false;
+      s.t_last = Clock::now();
+      s.mark = 0;
+      List(id);
+    }
+    m_heap.clear();
+    m_cur.clear();
+    m_last_reach = 0;
+    m_n_pending = 0;
+    m_n_built = 0;
+    m_n_late = 0;
+    m_max_lateness = 0;
+  }
+}
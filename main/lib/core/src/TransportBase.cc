@@ -26,6 +26,19 @@ namespace eudaq {
     m_callback = callback;
   }
 
+  void TransportBase::SendPacketParts(const std::vector<BlockView> &parts,
+                                      const ConnectionInfo &inf,
+                                      bool duringconnect) {
+    std::vector<unsigned char> buf;
+    size_t len = 0;
+    for (auto &p : parts)
+      len += p.size();
+    buf.reserve(len);
+    for (auto &p : parts)
+      buf.insert(buf.end(), p.begin(), p.end());
+    SendPacket(buf.data(), buf.size(), inf, duringconnect);
+  }
+
   void TransportBase::Process(int timeout) {
     if (timeout == -1)
       timeout = DEFAULT_TIMEOUT;
@@ -36,7 +49,7 @@ namespace eudaq {
       std::unique_lock<std::recursive_mutex> lk(m_mutex);
       if (m_events.empty())
         break;
-      TransportEvent evt(m_events.front());
+      TransportEvent evt(std::move(m_events.front()));
       m_events.pop();
       lk.unlock();
       m_callback(evt);
@@ -61,7 +74,7 @@ namespace eudaq {
     bool ret = false;
     if (!m_events.empty() && conn.Matches(*(m_events.front().id))) {
       ret = true;
-      *packet = m_events.front().packet;
+      *packet = std::move(m_events.front().packet);
       m_events.pop();
     }
     return ret;
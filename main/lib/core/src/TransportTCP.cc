@@ -54,6 +54,21 @@ at some places we have constructions like:
 #include "TransportTCP_POSIX.hh"
 #endif
 
+#if EUDAQ_PLATFORM_IS(LINUX)
+#include <sys/epoll.h>
+#endif
+
+#if !(EUDAQ_PLATFORM_IS(WIN32) || EUDAQ_PLATFORM_IS(MINGW))
+#include <sys/uio.h>
+#include <poll.h>
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+#endif
+
+#include <algorithm>
+#include <climits>
+
 // print debug messages that are optimized out if DEBUG_TRANSPORT is not set:
 // source and details:
 // http://stackoverflow.com/questions/1644868/c-define-macro-for-debug-printing
@@ -80,8 +95,10 @@ namespace eudaq {
   
   namespace {
     static const int MAXPENDING = 16;
-    static const int MAX_BUFFER_SIZE = 10000;
-    static int to_int(char c) { return static_cast<unsigned char>(c); }
+    // small packets are received in bulk through a buffer of this size,
+    // larger ones straight into the packet
+    static const int MAX_BUFFER_SIZE = 65536;
+    static const size_t MIN_DIRECT_SIZE = 4096;
 #ifdef MSG_NOSIGNAL
     // On Linux (and cygwin?) send(...) can be told to
     // ignore signals by setting the flag below
@@ -99,6 +116,25 @@ namespace eudaq {
     }
 #endif
 
+    // Blocks until the send buffer of the socket has room again, instead of
+    // spinning on send and taking the CPU away from the receiving side.
+    static void wait_writable(SOCKET sock) {
+#if EUDAQ_PLATFORM_IS(WIN32) || EUDAQ_PLATFORM_IS(MINGW)
+      fd_set wrset;
+      FD_ZERO(&wrset);
+      FD_SET(sock, &wrset);
+      timeval tv = {1, 0};
+      select(static_cast<int>(sock + 1), NULL, &wrset, NULL, &tv);
+#else
+      pollfd pfd;
+      pfd.fd = sock;
+      pfd.events = POLLOUT;
+      pfd.revents = 0;
+      poll(&pfd, 1, 1000);
+#endif
+    }
+
+#if EUDAQ_PLATFORM_IS(WIN32) || EUDAQ_PLATFORM_IS(MINGW)
     static void do_send_data(SOCKET sock, const unsigned char *data,
                              size_t len) {
       size_t sent = 0;
@@ -112,7 +148,8 @@ namespace eudaq {
 	else if (result < 0 &&
 		 (LastSockError() == EUDAQ_ERROR_Resource_temp_unavailable ||
 		  LastSockError() == EUDAQ_ERROR_Interrupted_function_call)){
-          // continue
+          if (LastSockError() == EUDAQ_ERROR_Resource_temp_unavailable)
+            wait_writable(sock);
         }
 	else if (result == 0) {
           EUDAQ_THROW_NOLOG("TransportTCP:: Connection reset by peer");
@@ -122,29 +159,82 @@ namespace eudaq {
         }
       } while (sent < len);
     }
+#endif
 
-    static void do_send_packet(SOCKET sock, const unsigned char *data,
-                               size_t length){
+    // Sends the parts behind a length prefix as one packet. On POSIX they are
+    // gathered by sendmsg, so the payload is neither copied nor split over
+    // several sends (with TCP_NODELAY each send may become its own segment).
+    static void do_send_parts(SOCKET sock, const BlockView *parts,
+                              size_t nparts) {
+      size_t length = 0;
+      for (size_t i = 0; i < nparts; ++i)
+        length += parts[i].size();
+      unsigned char header[4] = {0};
+      size_t len = length;
+      for (int i = 0; i < 4; ++i) {
+        header[i] = static_cast<unsigned char>(len & 0xff);
+        len >>= 8;
+      }
+#if EUDAQ_PLATFORM_IS(WIN32) || EUDAQ_PLATFORM_IS(MINGW)
       if (length < 1020) {
-        size_t len = length;
-        std::string buffer(len + 4, '\0');
-        for (int i = 0; i < 4; ++i) {
-          buffer[i] = static_cast<char>(len & 0xff);
-          len >>= 8;
-        }
-        std::copy(data, data + length, &buffer[4]);
-        do_send_data(sock, reinterpret_cast<const unsigned char *>(&buffer[0]),
-                     buffer.length());
+        std::vector<unsigned char> buffer(header, header + 4);
+        for (size_t i = 0; i < nparts; ++i)
+          buffer.insert(buffer.end(), parts[i].begin(), parts[i].end());
+        do_send_data(sock, buffer.data(), buffer.size());
       } else {
-        size_t len = length;
-        unsigned char buffer[4] = {0};
-        for (int i = 0; i < 4; ++i) {
-          buffer[i] = static_cast<unsigned char>(len & 0xff);
-          len >>= 8;
+        do_send_data(sock, header, 4);
+        for (size_t i = 0; i < nparts; ++i)
+          do_send_data(sock, parts[i].data(), parts[i].size());
+      }
+#else
+      std::vector<iovec> iov;
+      iov.reserve(nparts + 1);
+      iov.push_back(iovec{header, 4});
+      for (size_t i = 0; i < nparts; ++i)
+        if (parts[i].size())
+          iov.push_back(iovec{const_cast<uint8_t *>(parts[i].data()),
+                              parts[i].size()});
+      size_t first = 0;
+      while (first < iov.size()) {
+        msghdr msg;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov[first];
+        msg.msg_iovlen = std::min<size_t>(iov.size() - first, IOV_MAX);
+        ssize_t result = sendmsg(sock, &msg, FLAGS);
+        if (result > 0) {
+          size_t sent = result;
+          while (sent) {
+            if (sent >= iov[first].iov_len) {
+              sent -= iov[first].iov_len;
+              first++;
+            } else {
+              iov[first].iov_base =
+                  static_cast<char *>(iov[first].iov_base) + sent;
+              iov[first].iov_len -= sent;
+              sent = 0;
+            }
+          }
+        }
+        else if (result < 0 &&
+                 (LastSockError() == EUDAQ_ERROR_Resource_temp_unavailable ||
+                  LastSockError() == EUDAQ_ERROR_Interrupted_function_call)){
+          if (LastSockError() == EUDAQ_ERROR_Resource_temp_unavailable)
+            wait_writable(sock);
+        }
+        else if (result == 0) {
+          EUDAQ_THROW_NOLOG("TransportTCP:: Connection reset by peer");
+        }
+        else {
+          EUDAQ_THROW_NOLOG(LastSockErrorString("TransportTCP:: Error sending data"));
         }
-        do_send_data(sock, buffer, 4);
-        do_send_data(sock, data, length);
       }
+#endif
+    }
+
+    static void do_send_packet(SOCKET sock, const unsigned char *data,
+                               size_t length){
+      BlockView part(data, length);
+      do_send_parts(sock, &part, 1);
     }
 
   } // anonymous namespace
@@ -164,44 +254,93 @@ namespace eudaq {
     os << std::string(offset, ' ') << "</ConnectionTCP>\n";
   }
 
+  // The length prefix is not trusted for the allocation: the buffer grows
+  // with the data which has arrived, at most doubling each time.
+  void ConnectionInfoTCP::grow(size_t need) {
+    if (m_pkt.size() < need)
+      m_pkt.resize(std::min(m_len, std::max(need, m_pkt.size() * 2)));
+  }
+
   void ConnectionInfoTCP::append(size_t length, const char *data) {
-    m_buf += std::string(data, length);
-    update_length();
+    while (length) {
+      if (m_hdr_got < 4) {
+        size_t n = std::min(length, 4 - m_hdr_got);
+        std::memcpy(m_hdr + m_hdr_got, data, n);
+        m_hdr_got += n;
+        data += n;
+        length -= n;
+        if (m_hdr_got < 4)
+          break;
+        m_len = 0;
+        for (int i = 0; i < 4; ++i)
+          m_len |= static_cast<size_t>(m_hdr[i]) << (8 * i);
+        m_pkt.clear();
+        m_got = 0;
+      }
+      size_t n = std::min(length, m_len - m_got);
+      if (n) {
+        grow(m_got + n);
+        std::memcpy(&m_pkt[m_got], data, n);
+      }
+      data += n;
+      length -= n;
+      commit(n);
+    }
+  }
+
+  char *ConnectionInfoTCP::direct(size_t &length, size_t min) {
+    if (m_hdr_got < 4 || m_len - m_got < min)
+      return nullptr;
+    if (m_pkt.size() == m_got)
+      grow(m_got + std::max<size_t>(m_got, MAX_BUFFER_SIZE));
+    length = m_pkt.size() - m_got;
+    return &m_pkt[m_got];
+  }
+
+  void ConnectionInfoTCP::commit(size_t length) {
+    m_got += length;
+    if (m_hdr_got == 4 && m_got == m_len) {
+      m_ready.push_back(std::move(m_pkt));
+      m_pkt = std::string();
+      m_hdr_got = 0;
+      m_len = 0;
+      m_got = 0;
+    }
   }
 
   bool ConnectionInfoTCP::havepacket() const {
-    return m_buf.length() >= m_len + 4;
+    return !m_ready.empty();
   }
 
   std::string ConnectionInfoTCP::getpacket() {
     if (!havepacket())
       EUDAQ_THROW_NOLOG("TransprotTCP:: No packet available");
-    std::string packet(m_buf, 4, m_len);
-    m_buf.erase(0, m_len + 4);
-    update_length(true);
+    std::string packet(std::move(m_ready.front()));
+    m_ready.pop_front();
     return packet;
   }
 
-  void ConnectionInfoTCP::update_length(bool force) {
-    if (force || m_len == 0) {
-      m_len = 0;
-      if (m_buf.length() >= 4) {
-        for (int i = 0; i < 4; ++i) {
-          m_len |= to_int(m_buf[i]) << (8 * i);
-        }
-      }
-    }
-  }
-
   TCPServer::TCPServer(const std::string &param)
       : m_port(from_string(param, 0)),
-        m_srvsock(socket(PF_INET, SOCK_STREAM, IPPROTO_TCP)),
-        m_maxfd(m_srvsock) {
+        m_srvsock(socket(PF_INET, SOCK_STREAM, IPPROTO_TCP)) {
     if (m_srvsock == (SOCKET)-1)
       EUDAQ_THROW_NOLOG(LastSockErrorString("TCPServer:: Failed to create socket")); //$$ check if (SOCKET)-1 is correct
     setup_signal();
+#if EUDAQ_PLATFORM_IS(LINUX)
+    m_epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epfd < 0) {
+      closesocket(m_srvsock);
+      EUDAQ_THROW_NOLOG(LastSockErrorString("TCPServer:: Failed to create epoll instance"));
+    }
+    epoll_event ev;
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.fd = m_srvsock;
+    epoll_ctl(m_epfd, EPOLL_CTL_ADD, m_srvsock, &ev);
+#else
+    m_maxfd = m_srvsock;
     FD_ZERO(&m_fdset);
     FD_SET(m_srvsock, &m_fdset);
+#endif
 
     setup_socket(m_srvsock);
 
@@ -213,6 +352,9 @@ namespace eudaq {
 
     if (bind(m_srvsock, (sockaddr *)&addr, sizeof addr)) {
       closesocket(m_srvsock);
+#if EUDAQ_PLATFORM_IS(LINUX)
+      close(m_epfd);
+#endif
       EUDAQ_THROW_NOLOG(LastSockErrorString("TCPServer:: Failed to bind socket: " + param));
     }
     socklen_t addr_len = sizeof addr;
@@ -223,6 +365,9 @@ namespace eudaq {
     }
     if (listen(m_srvsock, MAXPENDING)){
       closesocket(m_srvsock);
+#if EUDAQ_PLATFORM_IS(LINUX)
+      close(m_epfd);
+#endif
       EUDAQ_THROW_NOLOG(
           LastSockErrorString("Failed to listen on socket: " + param));
     }
@@ -235,10 +380,14 @@ namespace eudaq {
       }
     }
     closesocket(m_srvsock);
+#if EUDAQ_PLATFORM_IS(LINUX)
+    close(m_epfd);
+#endif
   }
 
   std::shared_ptr<ConnectionInfoTCP> TCPServer::GetInfo(SOCKET fd) const {
     const ConnectionInfoTCP tofind(fd);
+    std::unique_lock<std::mutex> lk(m_mtx_conn);
     for(auto &conn: m_conn){
       if (conn && tofind.Matches(*conn) && conn->GetState() >= 0) {
 	return conn;
@@ -250,6 +399,7 @@ namespace eudaq {
   
   std::vector<ConnectionSPC> TCPServer::GetConnections () const{
     std::vector<ConnectionSPC> conns;
+    std::unique_lock<std::mutex> lk(m_mtx_conn);
     for(auto &conn: m_conn){
       if(conn)
 	conns.push_back(conn);
@@ -258,27 +408,177 @@ namespace eudaq {
   }
   
   void TCPServer::Close(const ConnectionInfo &id) {
+    std::vector<std::shared_ptr<ConnectionInfoTCP>> closing;
+    std::unique_lock<std::mutex> lk(m_mtx_conn);
     for(auto &conn: m_conn){
       if(conn && id.Matches(*conn)){
           SOCKET fd = conn->GetFd();
+#if EUDAQ_PLATFORM_IS(LINUX)
+          epoll_ctl(m_epfd, EPOLL_CTL_DEL, fd, nullptr);
+#else
           FD_CLR(fd, &m_fdset);
-          closesocket(fd);
+#endif
+	  closing.push_back(conn);
 	  conn.reset();
       }	
     }
+    lk.unlock();
+    for(auto &conn: closing){
+      // after a send to it has finished
+      std::unique_lock<std::mutex> ls(conn->SendMutex());
+      conn->SetClosed();
+      closesocket(conn->GetFd());
+    }
   }
   
+  void TCPServer::PauseReceive(const ConnectionInfo &id, bool pause) {
+    // may be called from any thread, the connection could be gone already
+    std::unique_lock<std::mutex> lk(m_mtx_conn);
+    for(auto &conn: m_conn){
+      if(conn.get() == &id && conn->IsPaused() != pause){
+        conn->SetPaused(pause);
+#if EUDAQ_PLATFORM_IS(LINUX)
+        // re-arming a ready socket raises a new edge, so pending data is not
+        // missed when resuming
+        epoll_event ev;
+        ev.events = (pause ? 0 : static_cast<uint32_t>(EPOLLIN)) | EPOLLRDHUP | EPOLLET;
+        ev.data.fd = conn->GetFd();
+        epoll_ctl(m_epfd, EPOLL_CTL_MOD, conn->GetFd(), &ev);
+#endif
+      }
+    }
+  }
+
+  std::vector<std::shared_ptr<ConnectionInfoTCP>>
+  TCPServer::Matching(const ConnectionInfo &id) const {
+    // a copy, so that a slow send does not hold up Accept and Close of the
+    // other connections
+    std::vector<std::shared_ptr<ConnectionInfoTCP>> conns;
+    std::unique_lock<std::mutex> lk(m_mtx_conn);
+    for(auto &conn: m_conn){
+      if(conn && id.Matches(*conn))
+        conns.push_back(conn);
+    }
+    return conns;
+  }
+
   void TCPServer::SendPacket(const unsigned char *data, size_t len,
                              const ConnectionInfo &id, bool duringconnect) { 
-    for(auto &conn: m_conn){
-      if(conn && id.Matches(*conn)){
-        if(conn->GetState() > 0 || duringconnect) {
+    for(auto &conn: Matching(id)){
+      if(conn->GetState() > 0 || duringconnect) {
+        std::unique_lock<std::mutex> ls(conn->SendMutex());
+        if(!conn->IsClosed())
           do_send_packet(conn->GetFd(), data, len);
+      }
+    }
+  }
+
+  void TCPServer::SendPacketParts(const std::vector<BlockView> &parts,
+                                  const ConnectionInfo &id,
+                                  bool duringconnect) {
+    for(auto &conn: Matching(id)){
+      if(conn->GetState() > 0 || duringconnect) {
+        std::unique_lock<std::mutex> ls(conn->SendMutex());
+        if(!conn->IsClosed())
+          do_send_parts(conn->GetFd(), parts.data(), parts.size());
+      }
+    }
+  }
+
+  void TCPServer::Accept() {
+    // the listening socket is non-blocking, take every pending connection
+    while (true) {
+      sockaddr_in addr;
+      socklen_t len = sizeof(addr);
+      SOCKET peersock = accept(static_cast<int>(m_srvsock), (sockaddr *)&addr, &len);
+      if (peersock == INVALID_SOCKET) {
+        if (LastSockError() == EUDAQ_ERROR_Resource_temp_unavailable ||
+            LastSockError() == EUDAQ_ERROR_Interrupted_function_call)
+          return;
+        EUDAQ_THROW_NOLOG(LastSockErrorString("Error in accept()"));
+      }
+#if EUDAQ_PLATFORM_IS(LINUX)
+      epoll_event ev;
+      ev.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+      ev.data.fd = peersock;
+      epoll_ctl(m_epfd, EPOLL_CTL_ADD, peersock, &ev);
+#else
+      FD_SET(peersock, &m_fdset);
+      m_maxfd = (m_maxfd < peersock) ? peersock : m_maxfd;
+#endif
+      setup_socket(peersock);
+      std::string host = inet_ntoa(addr.sin_addr);
+      host = "tcp://"+host+":" + to_string(ntohs(addr.sin_port));
+      auto conn_new = std::make_shared<ConnectionInfoTCP>(peersock, host);
+      std::unique_lock<std::mutex> lk(m_mtx_conn);
+      bool inserted = false;
+      for(auto &conn: m_conn) {
+        if(!conn) {
+          conn = conn_new;
+          inserted = true;
+          break;
         }
       }
+      if (!inserted)
+        m_conn.push_back(conn_new);
+      lk.unlock();
+      m_events.push(TransportEvent(TransportEvent::CONNECT, conn_new));
     }
   }
 
+  bool TCPServer::Receive(SOCKET fd) {
+    // drain the socket, as required by edge-triggered notification; a paused
+    // connection is re-armed when it is resumed
+    bool packet = false;
+    auto m = GetInfo(fd);
+    m_rdbuf.resize(MAX_BUFFER_SIZE);
+    while (!m->IsPaused()) {
+      size_t len = 0;
+      char *dst = m->direct(len, MIN_DIRECT_SIZE);
+      int result;
+      do {
+        if (dst)
+          result = recv(fd, dst, static_cast<int>(std::min<size_t>(len, INT_MAX)), 0);
+        else
+          result = recv(fd, &m_rdbuf[0], MAX_BUFFER_SIZE, 0);
+      } while (result == EUDAQ_ERROR_NO_DATA_RECEIVED &&
+               LastSockError() == EUDAQ_ERROR_Interrupted_function_call);
+
+      if (result > 0) {
+        if (dst)
+          m->commit(result);
+        else
+          m->append(result, &m_rdbuf[0]);
+        while (m->havepacket()) {
+          packet = true;
+          m_events.push(
+              TransportEvent(TransportEvent::RECEIVE, m, m->getpacket()));
+        }
+      }
+      else if (result == 0) {
+        debug_transport(
+            "Server #%d, return=%d, WSAError:%d (%s) Disconnected.\n", fd,
+            result, errno, strerror(errno));
+        m_events.push(TransportEvent(TransportEvent::DISCONNECT, m));
+        Close(*m);
+        return packet;
+      } else if (LastSockError() == EUDAQ_ERROR_Resource_temp_unavailable) {
+        debug_transport(
+            "Server #%d, return=%d, WSAError:%d (%s) No Data Received.\n",
+            fd, result, errno, strerror(errno));
+        return packet;
+      } else {
+        // e.g. connection reset by peer, the socket will not become readable again
+        debug_transport("Server #%d, return=%d, WSAError:%d (%s) \n", fd,
+                        result, errno, strerror(errno));
+        m_events.push(TransportEvent(TransportEvent::DISCONNECT, m));
+        Close(*m);
+        return packet;
+      }
+    }
+    return packet;
+  }
+
   void TCPServer::ProcessEvents(int timeout) {
 #if DEBUG_NOTIMEOUT == 0
     Time t_start = Time::Current(); /*t_curr = t_start,*/
@@ -286,8 +586,32 @@ namespace eudaq {
     Time t_remain = Time(0, timeout);
     bool done = false;
     do {
+#if EUDAQ_PLATFORM_IS(LINUX)
+      static const int MAX_EPOLL_EVENTS = 64;
+      epoll_event events[MAX_EPOLL_EVENTS];
+      timeval timeremain = t_remain;
+      int timeout_ms = timeremain.tv_sec < 0 ? 0 :
+        static_cast<int>(timeremain.tv_sec * 1000 + (timeremain.tv_usec + 999) / 1000);
+      int result = epoll_wait(m_epfd, events, MAX_EPOLL_EVENTS, timeout_ms);
+      if (result < 0 &&
+          LastSockError() != EUDAQ_ERROR_Interrupted_function_call) {
+        EUDAQ_THROW_NOLOG(LastSockErrorString("Error in epoll_wait()"));
+      }
+      for (int i = 0; i < result; i++) {
+        SOCKET fd = events[i].data.fd;
+        if (fd == m_srvsock)
+          Accept();
+        else if (Receive(fd))
+          done = true;
+      }
+#else
       fd_set tempset;
+      std::unique_lock<std::mutex> lk(m_mtx_conn);
       memcpy(&tempset, &m_fdset, sizeof(tempset));
+      for (auto &conn: m_conn)
+        if (conn && conn->IsPaused())
+          FD_CLR(conn->GetFd(), &tempset);
+      lk.unlock();
       timeval timeremain = t_remain;
       int result = select(static_cast<int>(m_maxfd + 1), &tempset, NULL, NULL,
                           &timeremain);
@@ -297,72 +621,16 @@ namespace eudaq {
                  LastSockError() != EUDAQ_ERROR_Interrupted_function_call) {
         EUDAQ_THROW_NOLOG(LastSockErrorString("Error in select()"));
       } else if (result > 0) {
-
         if (FD_ISSET(m_srvsock, &tempset)) {
-          sockaddr_in addr;
-          socklen_t len = sizeof(addr);
-          SOCKET peersock = accept(static_cast<int>(m_srvsock), (sockaddr *)&addr, &len);
-          if (peersock == INVALID_SOCKET) {
-	    EUDAQ_THROW_NOLOG(LastSockErrorString("Error in accept()"));
-          }
-	  else {
-            FD_SET(peersock, &m_fdset);
-            m_maxfd = (m_maxfd < peersock) ? peersock : m_maxfd;
-            setup_socket(peersock);
-            std::string host = inet_ntoa(addr.sin_addr);
-            host = "tcp://"+host+":" + to_string(ntohs(addr.sin_port));
-            auto conn_new = std::make_shared<ConnectionInfoTCP>(peersock, host);
-            bool inserted = false;
-            for(auto &conn: m_conn) {
-              if(!conn) {
-                conn = conn_new;
-                inserted = true;
-		break;
-              }
-            }
-            if (!inserted)
-              m_conn.push_back(conn_new);
-            m_events.push(TransportEvent(TransportEvent::CONNECT, conn_new));
-            FD_CLR(m_srvsock, &tempset);
-          }
+          Accept();
+          FD_CLR(m_srvsock, &tempset);
         }
         for (SOCKET j = 0; j < m_maxfd + 1; j++) {
-          if (FD_ISSET(j, &tempset)) {
-            char buffer[MAX_BUFFER_SIZE + 1];
-
-            do {
-              result = recv(j, buffer, MAX_BUFFER_SIZE, 0);
-            } while (result == EUDAQ_ERROR_NO_DATA_RECEIVED &&
-                     LastSockError() == EUDAQ_ERROR_Interrupted_function_call);
-
-            if (result > 0) {
-              buffer[result] = 0;
-	      auto m = GetInfo(j);
-              m->append(result, buffer);
-              while (m->havepacket()) {
-                done = true;
-                m_events.push(
-                    TransportEvent(TransportEvent::RECEIVE, m, m->getpacket()));
-              }
-            }
-            else if (result == 0) {
-              debug_transport(
-                  "Server #%d, return=%d, WSAError:%d (%s) Disconnected.\n", j,
-                  result, errno, strerror(errno));
-	      auto m = GetInfo(j);
-              m_events.push(TransportEvent(TransportEvent::DISCONNECT, m));
-	      Close(*m);
-            } else if (result == EUDAQ_ERROR_NO_DATA_RECEIVED) {
-              debug_transport(
-                  "Server #%d, return=%d, WSAError:%d (%s) No Data Received.\n",
-                  j, result, errno, strerror(errno));
-            } else {
-              debug_transport("Server #%d, return=%d, WSAError:%d (%s) \n", j,
-                              result, errno, strerror(errno));
-            }
-          }
+          if (FD_ISSET(j, &tempset) && Receive(j))
+            done = true;
         }
       }
+#endif
 
 // optionally disable timeout at compile time by setting DEBUG_NOTIMEOUT to 1
 #if DEBUG_NOTIMEOUT
@@ -435,6 +703,13 @@ namespace eudaq {
     }
   }
 
+  void TCPClient::SendPacketParts(const std::vector<BlockView> &parts,
+                                  const ConnectionInfo &id, bool) {
+    if(id.Matches(*m_buf)) {
+      do_send_parts(m_buf->GetFd(), parts.data(), parts.size());
+    }
+  }
+
   void TCPClient::ProcessEvents(int timeout) {
 #if DEBUG_NOTIMEOUT == 0
     Time t_start = Time::Current(); /*t_curr = t_start,*/
@@ -449,11 +724,15 @@ namespace eudaq {
       auto result = select(static_cast<int>(m_sock + 1), &tempset, NULL, NULL,
 			   &timeremain);
       bool donereading = false;
+      m_rdbuf.resize(MAX_BUFFER_SIZE);
       do {
-        char buffer[MAX_BUFFER_SIZE + 1];
-
+        size_t len = 0;
+        char *dst = m_buf->direct(len, MIN_DIRECT_SIZE);
         do {
-          result = recv(m_sock, buffer, MAX_BUFFER_SIZE, 0);
+          if (dst)
+            result = recv(m_sock, dst, static_cast<int>(std::min<size_t>(len, INT_MAX)), 0);
+          else
+            result = recv(m_sock, &m_rdbuf[0], MAX_BUFFER_SIZE, 0);
         } while (result == EUDAQ_ERROR_NO_DATA_RECEIVED &&
                  LastSockError() == EUDAQ_ERROR_Interrupted_function_call);
 
@@ -472,7 +751,10 @@ namespace eudaq {
           EUDAQ_THROW_NOLOG(LastSockErrorString(
               "SocketClient Error (" + to_string(LastSockError()) + ")"));
         } else if (result > 0) {
-          m_buf->append(result, buffer);
+          if (dst)
+            m_buf->commit(result);
+          else
+            m_buf->append(result, &m_rdbuf[0]);
           while (m_buf->havepacket()) {
             m_events.push(TransportEvent(TransportEvent::RECEIVE, m_buf,
                                          m_buf->getpacket()));
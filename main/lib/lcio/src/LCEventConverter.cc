@@ -1,4 +1,5 @@
 #include "eudaq/LCEventConverter.hh"
+#include "eudaq/ConverterRegistry.hh"
 
 namespace eudaq{
   
@@ -57,7 +58,7 @@ namespace eudaq{
     }
     
     uint32_t id = d1->GetType();
-    auto cvt = Factory<LCEventConverter>::MakeUnique(id);
+    auto cvt = ConverterRegistry<LCEventConverter>::Get(id, conf);
     if(cvt){
       return cvt->Converting(d1, d2, conf);
     }
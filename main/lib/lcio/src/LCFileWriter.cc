@@ -27,6 +27,8 @@ namespace eudaq {
   public:
     LCFileWriter(const std::string &patt);
     void WriteEvent(EventSPC ev) override;
+    std::shared_ptr<void> ConvertEvent(EventSPC ev) const override;
+    void WriteConverted(EventSPC ev, std::shared_ptr<void> cvt) override;
   private:
     std::unique_ptr<lcio::LCWriter> m_lcwriter;
     std::string m_filepattern;
@@ -38,6 +40,16 @@ namespace eudaq {
   }
 
   void LCFileWriter::WriteEvent(EventSPC ev) {
+    WriteConverted(ev, ConvertEvent(ev));
+  }
+
+  std::shared_ptr<void> LCFileWriter::ConvertEvent(EventSPC ev) const {
+    LCEventSP lcevent(new lcio::LCEventImpl);
+    LCEventConverter::Convert(ev, lcevent, GetConfiguration());
+    return lcevent;
+  }
+
+  void LCFileWriter::WriteConverted(EventSPC ev, std::shared_ptr<void> cvt) {
     uint32_t run_n = ev->GetRunN();
     if(!m_lcwriter || m_run_n != run_n){
       try {
@@ -56,8 +68,8 @@ namespace eudaq {
     }
     if(!m_lcwriter)
       EUDAQ_THROW("LCFileWriter: Attempt to write unopened file");
-    LCEventSP lcevent(new lcio::LCEventImpl);
-    LCEventConverter::Convert(ev, lcevent, GetConfiguration());
-    m_lcwriter->writeEvent(lcevent.get());
+    if(!cvt)
+      cvt = ConvertEvent(ev);
+    m_lcwriter->writeEvent(std::static_pointer_cast<lcio::LCEventImpl>(cvt).get());
   }
 }
@@ -1,4 +1,5 @@
 #include "eudaq/LCEventConverter.hh"
+#include "eudaq/ConverterRegistry.hh"
 #include "eudaq/RawEvent.hh"
 
 namespace eudaq{
@@ -21,7 +22,7 @@ namespace eudaq{
       return false;
     }
     uint32_t id = ev->GetExtendWord();
-    auto cvt = Factory<LCEventConverter>::MakeUnique(id);
+    auto cvt = ConverterRegistry<LCEventConverter>::Get(id, conf);
     if(cvt){
       cvt->Converting(d1, d2, conf);
       return true;
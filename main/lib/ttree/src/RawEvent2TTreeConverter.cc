@@ -1,4 +1,5 @@
 #include "eudaq/TTreeEventConverter.hh"
+#include "eudaq/ConverterRegistry.hh"
 #include "eudaq/RawEvent.hh"
 
 namespace eudaq{
@@ -22,7 +23,7 @@ namespace eudaq{
     }
     uint32_t id = ev->GetExtendWord();
     //    std::cout << " Sub Type " << ev->GetDescription() << std::endl;
-    auto cvt = Factory<TTreeEventConverter>::MakeUnique(id);
+    auto cvt = ConverterRegistry<TTreeEventConverter>::Get(id, conf);
      if(cvt){
       cvt->Converting(d1, d2, conf);
       return true;
@@ -1,4 +1,5 @@
 #include "eudaq/TTreeEventConverter.hh"
+#include "eudaq/ConverterRegistry.hh"
 
 namespace eudaq{
   
@@ -67,7 +68,7 @@ namespace eudaq{
     d2->Fill();      
 
     uint32_t id = d1->GetType();
-    auto cvt = Factory<TTreeEventConverter>::MakeUnique(id);
+    auto cvt = ConverterRegistry<TTreeEventConverter>::Get(id, conf);
     if(cvt){
       return cvt->Converting(d1, d2, conf);
     }
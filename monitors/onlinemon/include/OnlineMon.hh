@@ -17,6 +17,8 @@
 #include "eudaq/Logger.hh"
 #include "eudaq/Utils.hh"
 #include "eudaq/OptionParser.hh"
+#include "eudaq/StandardEvent.hh"
+#include "eudaq/LockFreeQueue.hh"
 #endif
 
 #include "HitmapCollection.hh"
@@ -35,6 +37,10 @@
 // STL includes
 #include <string>
 #include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 
 using namespace std;
 
@@ -73,6 +79,20 @@ class RootMonitor : public eudaq::Monitor{
   OnlineMonWindow *getOnlineMon() const;
   OnlineMonConfiguration mon_configdata; // FIXME
 private:
+  // a sampled event on its way from the converter to the collections
+  struct ConvertJob {
+    eudaq::EventSP ev;
+    eudaq::StandardEventSP stdev;
+    bool probe; // only counts the planes
+    std::atomic<int> state{0}; // 0 waiting, 1 converting, 2 converted
+    std::mutex mtx;
+    std::condition_variable cv;
+  };
+  static void Convert(ConvertJob &job);
+  void Filling();
+  void WaitFilled();
+  void FillEvent(eudaq::EventSP evsp, eudaq::StandardEventSP stdev, bool probe);
+
   bool histos_booked;
   std::vector<BaseCollection *> _colls;
   OnlineMonWindow *onlinemon;
@@ -98,7 +118,11 @@ class RootMonitor : public eudaq::Monitor{
   double previous_event_correlation_time;
   unsigned int tracksPerEvent;
   uint32_t m_plane_c;
-  uint32_t m_ev_rec_n = 0;
+  std::atomic<uint32_t> m_ev_rec_n{0}; // probes sent to the filler
+  eudaq::LockFreeQueue<std::shared_ptr<ConvertJob>> m_qu_fill;
+  std::thread m_th_fill;
+  std::atomic<uint32_t> m_n_fill{0}; // queued or being filled
+  std::atomic<uint64_t> m_n_dropped{0};
 };
 
 #ifdef __CINT__
@@ -45,12 +45,14 @@
 #include "OnlineMon.hh"
 #include "eudaq/StandardEvent.hh"
 #include "eudaq/StdEventConverter.hh"
+#include "eudaq/TaskExecutor.hh"
 using namespace std;
 
 RootMonitor::RootMonitor(const std::string & runcontrol,
 			 int /*x*/, int /*y*/, int /*w*/, int /*h*/,
 			 int argc, int offline, const std::string & conffile, const std::string & monname)
-  :eudaq::Monitor(monname, runcontrol), _offline(offline), _planesInitialized(false), onlinemon(NULL){
+  :eudaq::Monitor(monname, runcontrol), _offline(offline), _planesInitialized(false), onlinemon(NULL),
+   m_qu_fill(256){
   if (_offline <= 0)
   {
     onlinemon = new OnlineMonWindow(gClient->GetRoot(),800,600);
@@ -122,9 +124,13 @@ RootMonitor::RootMonitor(const std::string & runcontrol,
 
   onlinemon->SetOnlineMon(this);    
 
+  m_th_fill = std::thread(&RootMonitor::Filling, this);
 }
 
 RootMonitor::~RootMonitor(){
+  m_qu_fill.Close();
+  if(m_th_fill.joinable())
+    m_th_fill.join();
   gApplication->Terminate();
 }
 
@@ -178,15 +184,86 @@ void RootMonitor::DoTerminate(){
 }  
 
 void RootMonitor::DoReceive(eudaq::EventSP evsp) {
-  auto stdev = std::dynamic_pointer_cast<eudaq::StandardEvent>(evsp);
+  _checkEOF.EventReceived();
+  while(_offline <= 0 && onlinemon==NULL){
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  // sample first, only the events which go into the histograms are
+  // converted; the first ones tell the number of planes and are counted
+  // here, the filler sees them much later
+  bool probe = m_ev_rec_n < 10;
+  if(probe)
+    m_ev_rec_n++;
+  bool sample = _offline > 0 || probe ||
+    evsp->GetEventNumber() % onlinemon->getReduce() == 0;
+  if(!sample)
+    return;
+
+  auto job = std::make_shared<ConvertJob>();
+  job->ev = evsp;
+  job->probe = probe;
+  m_n_fill++;
+  // offline every event counts, online the collections which are not
+  // filled fast enough rather lose an event than hold up the receiving
+  bool queued = _offline > 0 || probe ? m_qu_fill.Push(std::shared_ptr<ConvertJob>(job))
+    : m_qu_fill.TryPush(job);
+  if(!queued){
+    m_n_fill--;
+    if(m_n_dropped++ == 0)
+      EUDAQ_WARN("OnlineMon: Filling the histograms falls behind, events are skipped");
+    return;
+  }
+  eudaq::TaskExecutor::Instance().Submit([job](){Convert(*job);});
+}
+
+void RootMonitor::Convert(ConvertJob &job){
+  int st = 0;
+  if(!job.state.compare_exchange_strong(st, 1))
+    return;
+  auto stdev = std::dynamic_pointer_cast<eudaq::StandardEvent>(job.ev);
   if(!stdev){
     stdev = eudaq::StandardEvent::MakeShared();
-    eudaq::StdEventConverter::Convert(evsp, stdev, nullptr); //no conf
+    try{
+      eudaq::StdEventConverter::Convert(job.ev, stdev, nullptr); //no conf
+    }catch(const std::exception &e){
+      EUDAQ_WARN(std::string("OnlineMon: Conversion failed: ") + e.what());
+    }
   }
+  std::lock_guard<std::mutex> lk(job.mtx);
+  job.stdev = stdev;
+  job.state = 2;
+  job.cv.notify_all();
+}
+
+void RootMonitor::Filling(){
+  // the collections are filled by this thread alone, in the order the
+  // events arrived, while the conversion runs on the executor
+  std::shared_ptr<ConvertJob> job;
+  for(;;){
+    if(!m_qu_fill.Pop(job, std::chrono::milliseconds(100))){
+      if(m_qu_fill.IsClosed())
+	return;
+      continue;
+    }
+    // a job no worker has started on yet is converted right here
+    Convert(*job);
+    std::unique_lock<std::mutex> lk(job->mtx);
+    job->cv.wait(lk, [&job]{return job->state == 2;});
+    lk.unlock();
+    FillEvent(job->ev, job->stdev, job->probe);
+    job.reset();
+    m_n_fill--;
+  }
+}
+
+void RootMonitor::WaitFilled(){
+  while(m_n_fill)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+}
 
+void RootMonitor::FillEvent(eudaq::EventSP evsp, eudaq::StandardEventSP stdev, bool probe) {
   uint32_t ev_plane_c = stdev->NumPlanes();
-  if(m_ev_rec_n < 10){
-    m_ev_rec_n ++;
+  if(probe){
     if(ev_plane_c > m_plane_c){
       m_plane_c = ev_plane_c;
     }
@@ -199,15 +276,11 @@ void RootMonitor::DoReceive(eudaq::EventSP evsp) {
   }
   
   auto &ev = *(stdev.get());
-  while(_offline <= 0 && onlinemon==NULL){
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
-  }
     
 #ifdef DEBUG
   cout << "Called onEvent " << ev.GetEventNumber()<< endl;
   cout << "Number of Planes " << ev.NumPlanes()<< endl;
 #endif
-  _checkEOF.EventReceived();
 
   //    cout << "Called onEvent " << ev.GetEventNumber()<< endl;
   //start timing to measure processing time
@@ -481,6 +554,7 @@ void RootMonitor::autoReset(const bool reset) {
 
 void RootMonitor::DoStopRun()
 {
+  WaitFilled();
   m_plane_c = 0;
   m_ev_rec_n = 0;
   while(_offline <= 0 && onlinemon==NULL){
@@ -0,0 +1,106 @@
+#include "eudaq/OptionParser.hh"
+#include "eudaq/FileReader.hh"
+#include "eudaq/StdEventConverter.hh"
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+// NI blocks of 6 boards with a hits per frame, in the layout the NI
+// producer sends
+std::vector<uint8_t> MakeNiBlock(std::mt19937 &rng, uint32_t hits){
+  std::vector<uint8_t> b(8, 0);
+  b[4] = 100; // pivot pixel
+  auto put16 = [&b](uint16_t v){b.push_back(v); b.push_back(v >> 8);};
+  auto put32 = [&put16](uint32_t v){put16(v); put16(v >> 16);};
+  for(uint32_t board = 0; board < 6; board++){
+    std::vector<uint16_t> w;
+    for(uint32_t h = 0; h < hits;){
+      uint16_t states = 1 + rng() % 3;
+      w.push_back((rng() % 576) << 4 | states);
+      for(uint16_t s = 0; s < states; s++){
+	uint16_t num = rng() % 4;
+	w.push_back((rng() % 1100) << 2 | num);
+	h += num + 1;
+      }
+    }
+    if(w.size() % 2)
+      w.push_back(0);
+    put32(board);
+    put16(w.size() / 2);
+    put16(w.size() / 2);
+    for(auto v: w)
+      put16(v);
+    put32(0);
+    put32(0);
+  }
+  return b;
+}
+
+int main(int /*argc*/, const char **argv) {
+  eudaq::OptionParser op("EUDAQ Command Line NI Converter Benchmark", "2.1",
+			 "Converts NiRawDataEvent to StandardEvent and reports the frames/s");
+  eudaq::Option<std::string> file_input(op, "i", "input", "", "string",
+					"input file, random NI blocks if none");
+  eudaq::Option<uint32_t> eventn(op, "n", "events", 2000, "uint32_t", "number of events");
+  eudaq::Option<uint32_t> hitn(op, "p", "pixels", 100, "uint32_t", "hits per frame of the random blocks");
+  eudaq::Option<uint32_t> repeatn(op, "r", "repeat", 5, "uint32_t", "passes over the events");
+  op.Parse(argv);
+
+  std::vector<eudaq::EventSPC> evs;
+  std::string infile_path = file_input.Value();
+  if(!infile_path.empty()){
+    std::string type_in = infile_path.substr(infile_path.find_last_of(".")+1);
+    if(type_in=="raw")
+      type_in = "native";
+    eudaq::FileReaderUP reader =
+      eudaq::Factory<eudaq::FileReader>::MakeUnique(eudaq::str2hash(type_in), infile_path);
+    while(evs.size() < eventn.Value()){
+      auto ev = reader->GetNextEvent();
+      if(!ev)
+	break;
+      if(ev->GetDescription() == "NiRawDataEvent")
+	evs.push_back(ev);
+      for(auto &sub_event : ev->GetSubEvents())
+	if(sub_event->GetDescription() == "NiRawDataEvent")
+	  evs.push_back(sub_event);
+    }
+  }
+  else{
+    std::mt19937 rng(1);
+    for(uint32_t i = 0; i < eventn.Value(); i++){
+      auto ev = eudaq::Event::MakeShared("NiRawDataEvent");
+      ev->AddBlock(0, MakeNiBlock(rng, hitn.Value()));
+      ev->AddBlock(1, MakeNiBlock(rng, hitn.Value()));
+      evs.push_back(ev);
+    }
+  }
+  if(evs.empty()){
+    std::cout << "No NiRawDataEvent to convert" << std::endl;
+    return 1;
+  }
+
+  double best = 0;
+  for(uint32_t r = 0; r < repeatn.Value(); r++){
+    uint64_t frames = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for(auto &ev: evs){
+      auto stdev = eudaq::StandardEvent::MakeShared();
+      eudaq::StdEventConverter::Convert(ev, stdev, nullptr);
+      for(size_t p = 0; p < stdev->NumPlanes(); p++)
+	frames += stdev->GetPlane(p).NumFrames();
+    }
+    double dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    if(!frames){
+      std::cout << "No frames converted, is the eudet module found (EUDAQ_MODULE_DIR)?" << std::endl;
+      return 1;
+    }
+    double fps = frames / dt;
+    best = std::max(best, fps);
+    std::cout << "pass " << r << ": " << evs.size() << " events, " << frames
+	      << " frames in " << dt << " s, " << uint64_t(fps) << " frames/s" << std::endl;
+  }
+  std::cout << "best " << uint64_t(best) << " frames/s" << std::endl;
+  return 0;
+}
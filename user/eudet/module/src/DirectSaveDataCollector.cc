@@ -8,6 +8,7 @@ namespace eudaq {
       using DataCollector::DataCollector;
       void DoConfigure() override;
       void DoReceive(ConnectionSPC id, EventSP ev) override;
+      void DoReceiveEvents(ConnectionSPC id, std::vector<EventSP> &evs) override;
       static const uint32_t m_id_factory = cstr2hash("DirectSaveDataCollector");
 
     private:
@@ -34,4 +35,11 @@ namespace eudaq {
       ev->Print(std::cout);
     WriteEvent(ev);
   }
+
+  void DirectSaveDataCollector::DoReceiveEvents(ConnectionSPC /*id*/, std::vector<EventSP> &evs){
+    if(!m_noprint)
+      for(auto &ev: evs)
+	ev->Print(std::cout);
+    WriteEvents(evs);
+  }
 }
@@ -1,22 +1,26 @@
 #include "eudaq/DataCollector.hh"
-//#include "eudaq/Event.hh"
+#include "eudaq/EventBuilder.hh"
 
-//#include <deque>
-//#include <map>
-//#include <string>
+#include <mutex>
+#include <unordered_map>
 
 namespace eudaq {
   class EventIDSyncDataCollector:public DataCollector{
     public:
       using DataCollector::DataCollector;
+      void DoConfigure() override;
       void DoStartRun() override;
+      void DoStatus() override;
       void DoConnect(ConnectionSPC /*id*/) override;
       void DoDisconnect(ConnectionSPC /*id*/) override;
       void DoReceive(ConnectionSPC id, EventSP ev) override;
       static const uint32_t m_id_factory = eudaq::cstr2hash("EventIDSyncDataCollector");
 
     private:
-      std::map<std::string, std::deque<EventSPC>> m_que_event;
+      void Build();
+      EventBuilder m_builder;
+      EventBuilder::Built m_built;
+      std::unordered_map<std::string, uint32_t> m_pdc_stream;
       std::mutex m_mtx_map;
   };
 
@@ -26,54 +30,73 @@ namespace eudaq {
       (EventIDSyncDataCollector::m_id_factory);
   }
 
+  void EventIDSyncDataCollector::DoConfigure(){
+    auto conf = GetConfiguration();
+    if(!conf)
+      return;
+    std::unique_lock<std::mutex> lk(m_mtx_map);
+    m_builder.Configure(EventBuilder::ParsePolicy(conf->Get("SYNC_MISSING", "partial")),
+                        conf->Get("SYNC_TIMEOUT_MS", 0),
+                        conf->Get("SYNC_MAX_QUEUE", 0));
+  }
+
   void EventIDSyncDataCollector::DoStartRun(){
     std::unique_lock<std::mutex> lk(m_mtx_map);
-    for(auto &que :m_que_event){
-      que.second.clear();
-    }
+    m_builder.Clear();
+  }
+
+  void EventIDSyncDataCollector::DoStatus(){
+    std::unique_lock<std::mutex> lk(m_mtx_map);
+    if(IsStatus(Status::STATE_RUNNING))
+      Build();
+    SetStatusTag("SyncPending", std::to_string(m_builder.GetPendingN()));
+    SetStatusTag("SyncIncomplete", std::to_string(m_builder.GetIncompleteN()));
+    SetStatusTag("SyncDropped", std::to_string(m_builder.GetDroppedN()));
+    SetStatusTag("SyncLate", std::to_string(m_builder.GetLateN()));
   }
 
   void EventIDSyncDataCollector::DoConnect(ConnectionSPC id){
     std::unique_lock<std::mutex> lk(m_mtx_map);
     std::string pdc_name = id->GetName();
     EUDAQ_INFO("Producer."+pdc_name+" is connecting");
-    if(m_que_event.find(pdc_name) != m_que_event.end())
+    if(m_pdc_stream.find(pdc_name) != m_pdc_stream.end())
       EUDAQ_THROW("DataCollector::Doconnect, multiple producers are sharing a same name");
-    m_que_event[pdc_name];
+    m_pdc_stream[pdc_name] = m_builder.AddStream(pdc_name);
   }
 
   void EventIDSyncDataCollector::DoDisconnect(ConnectionSPC id){
     std::unique_lock<std::mutex> lk(m_mtx_map);
     std::string pdc_name = id->GetName();
-    if(m_que_event.find(pdc_name) == m_que_event.end())
+    auto it = m_pdc_stream.find(pdc_name);
+    if(it == m_pdc_stream.end())
       EUDAQ_THROW("DataCollector::DisDoconnect, the disconnecting producer was not existing in list");
-    EUDAQ_WARN("Producer."+pdc_name+" is disconnected, the remaining events are erased. ("+std::to_string(m_que_event[pdc_name].size())+ " Events)");
-    m_que_event.erase(pdc_name);
+    EUDAQ_WARN("Producer."+pdc_name+" is disconnected, the remaining events are erased. ("+std::to_string(m_builder.GetPendingN(it->second))+ " Events)");
+    m_builder.RemoveStream(it->second, false);
+    m_pdc_stream.erase(it);
+    Build();
   }
 
   void EventIDSyncDataCollector::DoReceive(ConnectionSPC id, EventSP ev){
     std::unique_lock<std::mutex> lk(m_mtx_map);
-    std::string pdc_name = id->GetName();
-    m_que_event[pdc_name].push_back(std::move(ev));
-    uint32_t n = 0;
-    for(auto &que :m_que_event){
-      if(!que.second.empty())
-        n++;
-    }
-    if(n==m_que_event.size()){
+    auto it = m_pdc_stream.find(id->GetName());
+    if(it == m_pdc_stream.end())
+      EUDAQ_THROW("EventIDSyncDataCollector: Event from an unknown producer");
+    uint32_t ev_n = ev->GetEventN();
+    if(!m_builder.Push(it->second, ev_n, std::move(ev)) && m_builder.GetLateN() == 1)
+      EUDAQ_WARN("Producer." + id->GetName() + " sent event " + std::to_string(ev_n) +
+                 " too late, late events are discarded");
+    Build();
+  }
+
+  void EventIDSyncDataCollector::Build(){
+    while(m_builder.Next(m_built)){
+      if(m_built.missing && m_builder.GetIncompleteN() == 1)
+        EUDAQ_WARN("EventNumbers are Mismatched");
       auto ev_wrap = Event::MakeUnique("EventIDSyncOnline");
       ev_wrap->SetFlagPacket();
-      uint32_t ev_c = m_que_event.begin()->second.front()->GetEventN();
-      bool match = true;
-      for(auto &que :m_que_event){
-        if(ev_c != que.second.front()->GetEventN())
-          match = false;
-        ev_wrap->AddSubEvent(que.second.front());
-        que.second.pop_front();
-      }
-      if(!match){
-        EUDAQ_WARN("EventNumbers are Mismatched");
-      }
+      for(auto &sub: m_built.frags)
+        ev_wrap->AddSubEvent(sub);
+      m_built.frags.clear();
       WriteEvent(std::move(ev_wrap));
     }
   }
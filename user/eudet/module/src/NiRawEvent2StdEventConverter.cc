@@ -3,14 +3,20 @@
 #include "eudaq/RawEvent.hh"
 #include "eudaq/Logger.hh"
 
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #define PIVOTPIXELOFFSET 64
 
 class NiRawEvent2StdEventConverter: public eudaq::StdEventConverter{
-  typedef std::vector<uint8_t>::const_iterator datait;
+  typedef eudaq::BlockView::const_iterator datait;
 public:
   bool Converting(eudaq::EventSPC d1, eudaq::StandardEventSP d2, eudaq::ConfigurationSPC conf) const override;
-  void DecodeFrame(eudaq::StandardPlane& plane, const uint32_t fm_n,
-		   const uint8_t *const d, const size_t l32) const;
+  static uint32_t DecodeFrame(const uint8_t *const d, const size_t l32, const uint32_t pivot_row,
+			      uint16_t *x, uint16_t *y, uint8_t *piv);
   static const uint32_t m_id_factory = eudaq::cstr2hash("NiRawDataEvent");
 };
   
@@ -37,20 +43,24 @@ bool NiRawEvent2StdEventConverter::Converting(eudaq::EventSPC d1, eudaq::Standar
   }
     
   auto &rawev = *ev;
-  if (rawev.NumBlocks() < 2 || rawev.GetBlock(0).size() < 20 ||
-      rawev.GetBlock(1).size() < 20) {
+  if (rawev.NumBlocks() < 2 || rawev.GetBlockView(0).size() < 20 ||
+      rawev.GetBlockView(1).size() < 20) {
     EUDAQ_WARN("Ignoring bad event " + std::to_string(rawev.GetEventNumber()));
     return false;
   }
 
-  const std::vector<uint8_t> &data0 = rawev.GetBlock(0);
-  const std::vector<uint8_t> &data1 = rawev.GetBlock(1);
+  eudaq::BlockView data0 = rawev.GetBlockView(0);
+  eudaq::BlockView data1 = rawev.GetBlockView(1);
   uint32_t header0 = eudaq::getlittleendian<uint32_t>(&data0[0]);
   uint32_t header1 = eudaq::getlittleendian<uint32_t>(&data1[0]);
   uint16_t pivot = eudaq::getlittleendian<uint16_t>(&data0[4]);
   uint16_t tluid = eudaq::getlittleendian<uint16_t>(&data0[6]);
   datait it0 = data0.begin() + 8;
   datait it1 = data1.begin() + 8;
+  // hits of a frame before they go to the plane, every data word gives at
+  // most 4 hits and the decoder writes 4 at a time
+  thread_local std::vector<uint16_t> hit_x, hit_y;
+  thread_local std::vector<uint8_t> hit_piv;
   uint32_t board = 0;
   while (it0 < data0.end() && it1 < data1.end()) {
     uint32_t id = m_ids[board];
@@ -87,13 +97,22 @@ bool NiRawEvent2StdEventConverter::Converting(eudaq::EventSPC d1, eudaq::Standar
       break;
     }
 
-    eudaq::StandardPlane plane(id, "NI", "MIMOSA26");
+    // the hits go from the buffers straight into the plane of the event
+    eudaq::StandardPlane &plane = d2->AddPlane(eudaq::StandardPlane(id, "NI", "MIMOSA26"));
     plane.SetSizeZS(1152, 576, 0, 2, eudaq::StandardPlane::FLAG_WITHPIVOT |
 		    eudaq::StandardPlane::FLAG_DIFFCOORDS);
     plane.SetPivotPixel((9216 + pivot + PIVOTPIXELOFFSET) % 9216);
-    DecodeFrame(plane, 0, &it0[8], len0);
-    DecodeFrame(plane, 1, &it1[8], len1);
-    d2->AddPlane(plane);
+    size_t max_hits = (std::max(len0, len1) + 1) * 8;
+    if(hit_x.size() < max_hits){
+      hit_x.resize(max_hits);
+      hit_y.resize(max_hits);
+      hit_piv.resize(max_hits);
+    }
+    uint32_t pivot_row = plane.PivotPixel() / 16;
+    uint32_t n0 = DecodeFrame(&it0[8], len0, pivot_row, hit_x.data(), hit_y.data(), hit_piv.data());
+    plane.PushPixels(0, hit_x.data(), hit_y.data(), n0, hit_piv.data());
+    uint32_t n1 = DecodeFrame(&it1[8], len1, pivot_row, hit_x.data(), hit_y.data(), hit_piv.data());
+    plane.PushPixels(1, hit_x.data(), hit_y.data(), n1, hit_piv.data());
 
     bool advance_one_block_0 = false;
     bool advance_one_block_1 = false;
@@ -124,30 +143,42 @@ bool NiRawEvent2StdEventConverter::Converting(eudaq::EventSPC d1, eudaq::Standar
   return true;
 }
 
-void NiRawEvent2StdEventConverter::DecodeFrame(eudaq::StandardPlane& plane, const uint32_t fm_n,
-					       const uint8_t *const d, const size_t l32) const{
-  std::vector<uint16_t> vec;
-  for (size_t i = 0; i < l32; ++i) {
-    vec.push_back(eudaq::getlittleendian<uint16_t>(d+i*4));
-    vec.push_back(eudaq::getlittleendian<uint16_t>(d+i*4+2));
-  }
-
-  size_t lvec = vec.size();
+// The 16 bit words are read in place. A state word (row and number of
+// states) is followed by its column words, each giving 1 to 4 hits in
+// neighbouring columns; all 4 are written and the output advances by the
+// number of hits, which keeps the inner loop free of branches.
+uint32_t NiRawEvent2StdEventConverter::DecodeFrame(const uint8_t *const d, const size_t l32,
+						   const uint32_t pivot_row,
+						   uint16_t *x, uint16_t *y, uint8_t *piv){
+#ifdef __SSE2__
+  const __m128i step = _mm_setr_epi16(0, 1, 2, 3, 0, 0, 0, 0);
+#endif
+  size_t lvec = l32 * 2;
+  uint32_t n = 0;
   for (size_t i = 0; i+1 < lvec; ++i) {
-    uint16_t numstates = vec[i] & 0x000f;
-    uint16_t row = vec[i] >> 4 & 0x7ff;
+    uint16_t w = eudaq::getlittleendian<uint16_t>(d+i*2);
+    uint16_t numstates = w & 0x000f;
+    uint16_t row = w >> 4 & 0x7ff;
     if (i+1+numstates > lvec){ //offset+ [row] + [column......]
       break;
     }
-    bool pivot = (row >= (plane.PivotPixel() / 16));
+    uint8_t pivot = row >= pivot_row;
+    uint32_t fill = pivot * 0x01010101u;
     for (uint16_t s = 0; s < numstates; ++s) {
-      uint16_t v = vec.at(++i);
+      uint16_t v = eudaq::getlittleendian<uint16_t>(d+(++i)*2);
       uint16_t column = v >> 2 & 0x7ff;
-      uint16_t num = v & 3;
-      for (uint16_t j = 0; j < num + 1; ++j) {
-	plane.PushPixel(column + j, row, 1, pivot, fm_n);
+#ifdef __SSE2__
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(x+n), _mm_add_epi16(_mm_set1_epi16(column), step));
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(y+n), _mm_set1_epi16(row));
+#else
+      for (uint16_t j = 0; j < 4; ++j) {
+	x[n+j] = column + j;
+	y[n+j] = row;
       }
+#endif
+      std::memcpy(piv+n, &fill, 4);
+      n += (v & 3) + 1;
     }
   }
-      
+  return n;
 }
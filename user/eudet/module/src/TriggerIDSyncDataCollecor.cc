@@ -1,9 +1,8 @@
 #include "eudaq/DataCollector.hh"
+#include "eudaq/EventBuilder.hh"
 
-//#include <mutex>
-//#include <deque>
-//#include <map>
-#include <set>
+#include <mutex>
+#include <unordered_map>
 
 namespace eudaq {
   class TriggerIDSyncDataCollector:public DataCollector{
@@ -13,15 +12,19 @@ namespace eudaq {
       void DoConnect(ConnectionSPC id) override;
       void DoDisconnect(ConnectionSPC id) override;
       void DoConfigure() override;
+      void DoStartRun() override;
       void DoReset() override;
+      void DoStatus() override;
       void DoReceive(ConnectionSPC id, EventSP ev) override;
       static const uint32_t m_id_factory = cstr2hash("TriggerIDSyncDataCollector");
 
     private:
+      void Build();
       std::mutex m_mtx_map;
-      std::map<ConnectionSPC, std::deque<EventSPC>> m_conn_evque;
-      std::set<ConnectionSPC> m_conn_inactive;
-      uint32_t m_noprint;
+      EventBuilder m_builder;
+      EventBuilder::Built m_built;
+      std::unordered_map<const ConnectionInfo*, uint32_t> m_conn_stream;
+      uint32_t m_print;
   };
 
   namespace{
@@ -32,38 +35,59 @@ namespace eudaq {
 
   TriggerIDSyncDataCollector::TriggerIDSyncDataCollector(const std::string &name,
       const std::string &rc):
-    DataCollector(name, rc){
+    DataCollector(name, rc), m_print(0){
+      m_builder.Configure(EventBuilder::MISSING_PARTIAL, 0, 0);
     }
 
   void TriggerIDSyncDataCollector::DoConnect(ConnectionSPC idx){
     std::unique_lock<std::mutex> lk(m_mtx_map);
-    m_conn_evque[idx].clear();
-    m_conn_inactive.erase(idx);
+    m_conn_stream[idx.get()] = m_builder.AddStream(idx->GetName());
   }
 
   void TriggerIDSyncDataCollector::DoDisconnect(ConnectionSPC idx){
     std::unique_lock<std::mutex> lk(m_mtx_map);
-    m_conn_inactive.insert(idx);
-    if(m_conn_inactive.size() == m_conn_evque.size()){
-      m_conn_inactive.clear();
-      m_conn_evque.clear();
-    }
+    auto it = m_conn_stream.find(idx.get());
+    if(it == m_conn_stream.end())
+      return;
+    // the queued events of the producer are still built
+    m_builder.RemoveStream(it->second, true);
+    m_conn_stream.erase(it);
+    Build();
   }
 
   void TriggerIDSyncDataCollector::DoConfigure(){
-    m_noprint = 0;
     auto conf = GetConfiguration();
     if(conf){
       conf->Print();
-      m_noprint = conf->Get("DISABLE_PRINT", 0);
+      // DISABLE_PRINT = 0 of older configurations still turns printing on
+      m_print = conf->Get("ENABLE_PRINT", conf->Get("DISABLE_PRINT", 1) ? 0 : 1);
+      std::unique_lock<std::mutex> lk(m_mtx_map);
+      m_builder.Configure(EventBuilder::ParsePolicy(conf->Get("SYNC_MISSING", "partial")),
+                          conf->Get("SYNC_TIMEOUT_MS", 0),
+                          conf->Get("SYNC_MAX_QUEUE", 0));
     }
   }
 
+  void TriggerIDSyncDataCollector::DoStartRun(){
+    std::unique_lock<std::mutex> lk(m_mtx_map);
+    m_builder.Clear();
+  }
+
   void TriggerIDSyncDataCollector::DoReset(){
     std::unique_lock<std::mutex> lk(m_mtx_map);
-    m_noprint = 0;
-    m_conn_evque.clear();
-    m_conn_inactive.clear();
+    m_print = 0;
+    m_builder.Clear();
+  }
+
+  void TriggerIDSyncDataCollector::DoStatus(){
+    std::unique_lock<std::mutex> lk(m_mtx_map);
+    // timeouts also expire when no data arrives
+    if(IsStatus(Status::STATE_RUNNING))
+      Build();
+    SetStatusTag("SyncPending", std::to_string(m_builder.GetPendingN()));
+    SetStatusTag("SyncIncomplete", std::to_string(m_builder.GetIncompleteN()));
+    SetStatusTag("SyncDropped", std::to_string(m_builder.GetDroppedN()));
+    SetStatusTag("SyncLate", std::to_string(m_builder.GetLateN()));
   }
 
   void TriggerIDSyncDataCollector::DoReceive(ConnectionSPC idx, EventSP evsp){
@@ -71,45 +95,28 @@ namespace eudaq {
     if(!evsp->IsFlagTrigger()){
       EUDAQ_THROW("!evsp->IsFlagTrigger()");
     }
-    m_conn_evque[idx].push_back(evsp);
-
-    uint32_t trigger_n = -1;
-    for(auto &conn_evque: m_conn_evque){
-      if(conn_evque.second.empty())
-        return;
-      else{
-        uint32_t trigger_n_ev = conn_evque.second.front()->GetTriggerN();
-        if(trigger_n_ev< trigger_n)
-          trigger_n = trigger_n_ev;
-      }
-    }
-
-    auto ev_sync = Event::MakeUnique("TriggerIDSyncOnline");
-    ev_sync->SetFlagPacket();
-    ev_sync->SetTriggerN(trigger_n);
-    for(auto &conn_evque: m_conn_evque){
-      auto &ev_front = conn_evque.second.front(); 
-      if(ev_front->GetTriggerN() == trigger_n){
-        ev_sync->AddSubEvent(ev_front);
-        conn_evque.second.pop_front();
-      }
-    }
+    auto it = m_conn_stream.find(idx.get());
+    if(it == m_conn_stream.end())
+      EUDAQ_THROW("TriggerIDSyncDataCollector: Event from an unknown connection");
+    uint32_t trigger_n = evsp->GetTriggerN();
+    if(!m_builder.Push(it->second, trigger_n, std::move(evsp)) &&
+       m_builder.GetLateN() == 1)
+      EUDAQ_WARN("Producer." + idx->GetName() + " sent trigger " +
+                 std::to_string(trigger_n) + " too late, late events are discarded");
+    Build();
+  }
 
-    if(!m_conn_inactive.empty()){
-      std::set<ConnectionSPC> conn_inactive_empty;
-      for(auto &conn: m_conn_inactive){
-        if(m_conn_evque.find(conn) != m_conn_evque.end() && 
-            m_conn_evque[conn].empty()){
-          m_conn_evque.erase(conn);
-          conn_inactive_empty.insert(conn);	
-        }
-      }
-      for(auto &conn: conn_inactive_empty){
-        m_conn_inactive.erase(conn);
-      }
+  void TriggerIDSyncDataCollector::Build(){
+    while(m_builder.Next(m_built)){
+      auto ev_sync = Event::MakeUnique("TriggerIDSyncOnline");
+      ev_sync->SetFlagPacket();
+      ev_sync->SetTriggerN(m_built.key);
+      for(auto &ev: m_built.frags)
+        ev_sync->AddSubEvent(ev);
+      m_built.frags.clear();
+      if(m_print)
+        ev_sync->Print(std::cout);
+      WriteEvent(std::move(ev_sync));
     }
-    if(!m_noprint)
-      ev_sync->Print(std::cout);
-    WriteEvent(std::move(ev_sync));
   }
 }
@@ -0,0 +1,85 @@
+#include "eudaq/OptionParser.hh"
+#include "eudaq/FileReader.hh"
+#include "eudaq/StdEventConverter.hh"
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+// Converts Timepix3 events, as written by euCliTimepix3Replay or the
+// Timepix3Producer, to StandardEvents and reports the rate.
+int main(int /*argc*/, const char **argv) {
+  eudaq::OptionParser op("EUDAQ Command Line Timepix3 Converter Benchmark", "2.1",
+			 "Converts Timepix3RawDataEvent to StandardEvent and reports the pixels/s");
+  eudaq::Option<std::string> file_input(op, "i", "input", "", "string",
+					"input file, random events if none");
+  eudaq::Option<uint32_t> eventn(op, "n", "events", 2000, "uint32_t", "number of events");
+  eudaq::Option<uint32_t> pixeln(op, "p", "pixels", 100, "uint32_t", "pixels per random event");
+  eudaq::Option<uint32_t> repeatn(op, "r", "repeat", 5, "uint32_t", "passes over the events");
+  op.Parse(argv);
+
+  std::vector<eudaq::EventSPC> evs;
+  std::string infile_path = file_input.Value();
+  if(!infile_path.empty()){
+    std::string type_in = infile_path.substr(infile_path.find_last_of(".")+1);
+    if(type_in=="raw")
+      type_in = "native";
+    eudaq::FileReaderUP reader =
+      eudaq::Factory<eudaq::FileReader>::MakeUnique(eudaq::str2hash(type_in), infile_path);
+    while(evs.size() < eventn.Value()){
+      auto ev = reader->GetNextEvent();
+      if(!ev)
+	break;
+      if(ev->GetDescription() == "Timepix3RawDataEvent")
+	evs.push_back(ev);
+      for(auto &sub_event : ev->GetSubEvents())
+	if(sub_event->GetDescription() == "Timepix3RawDataEvent")
+	  evs.push_back(sub_event);
+    }
+  }
+  else{
+    // blocks as Timepix3EventBuilder::PackTrigger and PackPixels give them
+    std::mt19937_64 rng(1);
+    for(uint32_t i = 0; i < eventn.Value(); i++){
+      std::vector<uint8_t> trg(20, 0), pix;
+      for(uint32_t p = 0; p < pixeln.Value(); p++){
+	uint64_t r = rng();
+	pix.push_back(r & 0xFF);
+	pix.push_back(r >> 8 & 0xFF);
+	pix.push_back(r >> 16 & 0xFF);
+	pix.push_back(r >> 24 & 0x03);
+	for(uint32_t b = 0; b < 8; b++)
+	  pix.push_back(uint8_t((uint64_t(i) << 20 | p) >> (8 * b)));
+      }
+      auto ev = eudaq::Event::MakeShared("Timepix3RawDataEvent");
+      ev->AddBlock(0, trg);
+      ev->AddBlock(1, pix);
+      evs.push_back(ev);
+    }
+  }
+  if(evs.empty()){
+    std::cout << "No Timepix3RawDataEvent to convert" << std::endl;
+    return 1;
+  }
+
+  double best = 0;
+  for(uint32_t r = 0; r < repeatn.Value(); r++){
+    uint64_t pixels = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for(auto &ev: evs){
+      auto stdev = eudaq::StandardEvent::MakeShared();
+      eudaq::StdEventConverter::Convert(ev, stdev, nullptr);
+      for(size_t p = 0; p < stdev->NumPlanes(); p++)
+	pixels += stdev->GetPlane(p).HitPixels();
+    }
+    double dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    double pps = pixels / dt;
+    best = std::max(best, pps);
+    std::cout << "pass " << r << ": " << evs.size() << " events, " << pixels
+	      << " pixels in " << dt << " s, " << uint64_t(evs.size() / dt) << " events/s, "
+	      << uint64_t(pps) << " pixels/s" << std::endl;
+  }
+  std::cout << "best " << uint64_t(best) << " pixels/s" << std::endl;
+  return 0;
+}
@@ -0,0 +1,73 @@
+#include "eudaq/OptionParser.hh"
+#include "eudaq/FileWriter.hh"
+#include "eudaq/Event.hh"
+#include "Timepix3EventBuilder.h"
+
+#include <iostream>
+#include <fstream>
+#include <chrono>
+
+// Builds the Timepix3 events from a SPIDR packet dump, as written by the
+// Timepix3Producer with SPIDR_DumpFile, without the hardware.
+int main(int /*argc*/, const char **argv) {
+  eudaq::OptionParser op("EUDAQ Command Line Timepix3 Replay", "2.1", "Event building from a SPIDR packet dump");
+  eudaq::Option<std::string> file_input(op, "i", "input", "", "string", "SPIDR packet dump");
+  eudaq::Option<std::string> file_output(op, "o", "output", "", "string", "output file, none if empty");
+  eudaq::Option<uint32_t> max_pixels(op, "m", "maxpixels", 10000, "uint32_t", "MaxPixelVecSize of the producer");
+  eudaq::Option<uint32_t> pixels_to_drop(op, "d", "drop", 5000, "uint32_t", "NpixelsToDelete of the producer");
+  op.Parse(argv);
+
+  std::ifstream dump(file_input.Value(), std::ios::binary);
+  if(!dump){
+    std::cerr << "Cannot open " << file_input.Value() << std::endl;
+    return 1;
+  }
+
+  eudaq::FileWriterUP writer;
+  std::string outfile_path = file_output.Value();
+  if(!outfile_path.empty()){
+    std::string type_out = outfile_path.substr(outfile_path.find_last_of(".")+1);
+    if(type_out=="raw")
+      type_out = "native";
+    writer = eudaq::Factory<eudaq::FileWriter>::MakeUnique(eudaq::str2hash(type_out), outfile_path);
+  }
+
+  Timepix3EventBuilder builder(max_pixels.Value(), pixels_to_drop.Value());
+  Timepix3EventBuilder::TRIGGER trigger;
+  std::vector<Timepix3EventBuilder::PIXEL> pixels;
+  std::vector<uint64_t> packets(1 << 20);
+  uint64_t packet_n = 0, event_n = 0, pixel_n = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  while(dump){
+    dump.read(reinterpret_cast<char*>(packets.data()), packets.size()*sizeof(uint64_t));
+    size_t n = dump.gcount() / sizeof(uint64_t);
+    for(size_t i = 0; i < n; i++){
+      builder.AddPacket(packets[i]);
+      while(builder.NextEvent(trigger, pixels)){
+	pixel_n += pixels.size();
+	if(writer){
+	  auto ev = eudaq::Event::MakeShared("Timepix3RawDataEvent");
+	  ev->SetTriggerN(event_n);
+	  std::vector<unsigned char> bufferTrg;
+	  std::vector<unsigned char> bufferPix;
+	  Timepix3EventBuilder::PackTrigger(trigger, bufferTrg);
+	  Timepix3EventBuilder::PackPixels(pixels, bufferPix);
+	  ev->AddBlock(0, bufferTrg);
+	  ev->AddBlock(1, bufferPix);
+	  writer->WriteEvent(ev);
+	}
+	event_n++;
+      }
+    }
+    packet_n += n;
+  }
+  double dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::cout << "packets: " << packet_n << ", events: " << event_n << ", pixels: " << pixel_n
+	    << ", pixels dropped: " << builder.GetDroppedN()
+	    << ", pixels left: " << builder.GetPixelN() << std::endl;
+  std::cout << "time: " << dt << " s, " << (dt > 0 ? event_n / dt : 0) << " events/s, "
+	    << (dt > 0 ? packet_n / dt : 0) << " packets/s" << std::endl;
+  return 0;
+}
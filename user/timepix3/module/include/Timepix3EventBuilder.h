@@ -0,0 +1,61 @@
+#ifndef TIMEPIX3EVENTBUILDER_H
+#define TIMEPIX3EVENTBUILDER_H
+
+#include <vector>
+#include <deque>
+#include <cstdint>
+#include <cstddef>
+
+// Decodes the SPIDR data-driven packets of one Timepix3 and matches the
+// pixels to the TLU triggers: a trigger gets all pixels older than the
+// middle between it and the next trigger. The pixels are kept sorted by
+// timestamp, so an event is a sweep from the oldest pixel on.
+// Independent of the hardware, so it can be run on recorded packets.
+class Timepix3EventBuilder {
+public:
+  // Structure to store pixel info
+  struct PIXEL {
+    unsigned char x, y;
+    unsigned short tot;
+    uint64_t ts;
+  };
+
+  // Structure to store trigger info
+  struct TRIGGER {
+    unsigned short int_nr, tlu_nr;
+    uint64_t ts;
+  };
+
+  // the oldest pixels_to_drop pixels are dropped once more than max_pixels
+  // wait for a trigger
+  Timepix3EventBuilder(size_t max_pixels = 10000, size_t pixels_to_drop = 5000);
+  void Reset();
+
+  // returns false for a packet which is neither pixel nor trigger data
+  bool AddPacket(uint64_t data);
+  void AddPixel(const PIXEL &pixel);
+  void AddTrigger(const TRIGGER &trigger);
+  // the oldest trigger and its pixels, once the following trigger is known
+  bool NextEvent(TRIGGER &trigger, std::vector<PIXEL> &pixels);
+
+  // the blocks of a Timepix3RawDataEvent
+  static void PackTrigger(const TRIGGER &trigger, std::vector<unsigned char> &block);
+  static void PackPixels(const std::vector<PIXEL> &pixels, std::vector<unsigned char> &block);
+
+  size_t GetPixelN() const { return m_pix.size() - m_head; };
+  size_t GetTriggerN() const { return m_trg.size(); };
+  uint64_t GetDroppedN() const { return m_dropped; };
+
+private:
+  void Unfold(int fpga_ts, long long &ts);
+
+  size_t m_max_pixels, m_pixels_to_drop;
+  std::vector<PIXEL> m_pix; // sorted, the ones before m_head are used
+  size_t m_head;
+  std::deque<TRIGGER> m_trg;
+  uint64_t m_unfolded_timestamp;
+  int m_last_fpga_ts;
+  uint64_t m_dropped;
+};
+
+#endif // TIMEPIX3EVENTBUILDER_H
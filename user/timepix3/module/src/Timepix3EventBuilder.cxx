@@ -0,0 +1,157 @@
+#include "Timepix3EventBuilder.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+  const int HALF_EPOCH = 0x8000;
+  const uint64_t TIMER_EPOCH = 0x40000000;
+
+  bool EarlierThan(const Timepix3EventBuilder::PIXEL &a, const Timepix3EventBuilder::PIXEL &b) {
+    return a.ts < b.ts;
+  }
+}
+
+Timepix3EventBuilder::Timepix3EventBuilder(size_t max_pixels, size_t pixels_to_drop)
+  : m_max_pixels(max_pixels), m_pixels_to_drop(pixels_to_drop) {
+  Reset();
+}
+
+void Timepix3EventBuilder::Reset() {
+  m_pix.clear();
+  m_head = 0;
+  m_trg.clear();
+  m_unfolded_timestamp = 0;
+  m_last_fpga_ts = 0x00000; //SAMIR: was 0x10000
+  m_dropped = 0;
+}
+
+// ts has the 16 bit FPGA timestamp fpga_ts in its upper bits
+void Timepix3EventBuilder::Unfold(int fpga_ts, long long &ts) {
+  if( fpga_ts < m_last_fpga_ts - HALF_EPOCH ) {
+    m_unfolded_timestamp += TIMER_EPOCH;
+    m_last_fpga_ts = fpga_ts;
+  } else if( fpga_ts >= m_last_fpga_ts + HALF_EPOCH ) {
+    ts -= TIMER_EPOCH;
+  } else {
+    m_last_fpga_ts = fpga_ts;
+  }
+  ts += m_unfolded_timestamp;
+}
+
+bool Timepix3EventBuilder::AddPacket(uint64_t data) {
+  uint64_t header = data & 0xF000000000000000;
+
+  // Data-driven or sequential readout pixel data header?
+  if( header == 0xB000000000000000 || header == 0xA000000000000000 ) {
+    PIXEL pixel;
+    // doublecolumn * 2
+    uint64_t dcol = (( data & 0x0FE0000000000000 ) >> 52 ); //(16+28+9-1)
+    // superpixel * 4
+    uint64_t spix = (( data & 0x001F800000000000 ) >> 45 ); //(16+28+3-2)
+    // pixel
+    uint64_t pix  = (( data & 0x0000700000000000) >> 44 ); //(16+28)
+    pixel.x = (unsigned char) ( dcol + pix/4 );
+    pixel.y = (unsigned char) ( spix + ( pix & 0x3 ) );
+    // pixel data
+    uint64_t pixdata = (int) (( data & 0x00000FFFFFFF0000 ) >> 16 );
+    pixel.tot = ( pixdata >> 4 ) & 0x3FF;
+
+    // timestamp calculation
+    unsigned char ftoa = pixdata & 0xF;
+    uint64_t toa = ( pixdata >> 14 ) & 0x3FFF;
+    uint64_t fpga_ts = (int) (data & 0x000000000000FFFF);
+    long long pix_ts = ( fpga_ts << 14 ) | toa;
+    Unfold((int)fpga_ts, pix_ts);
+    pix_ts <<= 4;
+    pix_ts -= ftoa;
+    pixel.ts = pix_ts;
+    AddPixel(pixel);
+    return true;
+  }
+
+  // Or TLU packet header?
+  if( header == 0x5000000000000000 ) {
+    TRIGGER trigger;
+    //internal trigger number
+    trigger.int_nr = (data >> 45) & 0x7FFF;
+    //TLU trigger number
+    trigger.tlu_nr = (data >> 30) & 0x7FFF;
+    //timestamp
+    long long trg_timestamp = data & 0x3FFFFFFF;
+    uint64_t fpga_ts = (int) ((trg_timestamp>>14) & 0x000000000000FFFF);
+    Unfold((int)fpga_ts, trg_timestamp);
+    trg_timestamp <<= 4;
+    trigger.ts = trg_timestamp;
+    AddTrigger(trigger);
+    return true;
+  }
+  return false;
+}
+
+void Timepix3EventBuilder::AddPixel(const PIXEL &pixel) {
+  // the readout is nearly time ordered, a late pixel is moved back by a
+  // few places
+  if( m_pix.size() == m_head || !EarlierThan(pixel, m_pix.back()) ) {
+    m_pix.push_back(pixel);
+  } else {
+    auto begin = m_pix.begin() + m_head;
+    auto it = m_pix.end() - 1;
+    for( int k = 0; k < 8 && it != begin && EarlierThan(pixel, *(it - 1)); k++ )
+      --it;
+    if( it != begin && EarlierThan(pixel, *(it - 1)) )
+      it = std::upper_bound(begin, it, pixel, EarlierThan);
+    m_pix.insert(it, pixel);
+  }
+
+  // too much back log, the oldest pixels go
+  if( GetPixelN() > m_max_pixels ) {
+    size_t n = std::min(m_pixels_to_drop, GetPixelN());
+    m_head += n;
+    m_dropped += n;
+  }
+  // the used pixels are removed at once, when they are the larger part
+  if( m_head > 4096 && m_head * 2 > m_pix.size() ) {
+    m_pix.erase(m_pix.begin(), m_pix.begin() + m_head);
+    m_head = 0;
+  }
+}
+
+void Timepix3EventBuilder::AddTrigger(const TRIGGER &trigger) {
+  m_trg.push_back(trigger);
+}
+
+bool Timepix3EventBuilder::NextEvent(TRIGGER &trigger, std::vector<PIXEL> &pixels) {
+  if( m_trg.size() < 2 )
+    return false;
+  trigger = m_trg[0];
+  uint64_t max_pixel_ts = ( m_trg[1].ts + trigger.ts ) / 2;
+  m_trg.pop_front();
+
+  size_t begin = m_head;
+  while( m_head < m_pix.size() && m_pix[m_head].ts < max_pixel_ts )
+    ++m_head;
+  pixels.assign(m_pix.begin() + begin, m_pix.begin() + m_head);
+  return true;
+}
+
+void Timepix3EventBuilder::PackTrigger(const TRIGGER &trigger, std::vector<unsigned char> &block) {
+  uint64_t words[3] = { trigger.ts, trigger.tlu_nr, trigger.int_nr };
+  size_t b = block.size();
+  block.resize(b + sizeof(words));
+  std::memcpy(&block[b], words, sizeof(words));
+}
+
+// Size of one pixel data chunk: 12 bytes = 1+1+2+8 bytes for x,y,tot,ts
+void Timepix3EventBuilder::PackPixels(const std::vector<PIXEL> &pixels, std::vector<unsigned char> &block) {
+  size_t b = block.size();
+  block.resize(b + pixels.size() * 12);
+  unsigned char *d = block.data() + b;
+  for( auto &p : pixels ) {
+    d[0] = p.x;
+    d[1] = p.y;
+    std::memcpy(d + 2, &p.tot, 2);
+    std::memcpy(d + 4, &p.ts, 8);
+    d += 12;
+  }
+}
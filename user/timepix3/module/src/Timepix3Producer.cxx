@@ -3,6 +3,7 @@
 
 #include <iostream>
 #include <ostream>
+#include <fstream>
 #include <vector>
 #include <unistd.h>
 #include <iomanip>
@@ -14,6 +15,7 @@
 #include <ctime>
 #endif
 #include "Timepix3Config.h"
+#include "Timepix3EventBuilder.h"
 
 //#include "gpib/ib.h"
 //#include "Keithley2450.h"
@@ -37,19 +39,6 @@ class Timepix3Producer : public eudaq::Producer {
   double getTpx3Temperature();
   uint64_t GetTimeus();
 
-  // Structure to store pixel info
-  struct PIXEL {
-    unsigned char x, y;
-    unsigned short tot;
-    uint64_t ts;
-  };
-
-  // Structure to store trigger info
-  struct TRIGGER {
-    unsigned short int_nr, tlu_nr;
-    uint64_t ts;
-  };
-
   unsigned m_ev;
   int m_spidrPort;
   int device_nr = 0;
@@ -65,6 +54,7 @@ class Timepix3Producer : public eudaq::Producer {
   int m_do_threshold_scan, m_threshold_start, m_threshold_step, m_threshold_max, m_threshold_return, m_threshold_count;
   float m_temp;
   int m_maxPixVec, m_pixToDel;
+  string m_dumpfileName;
 };
 
 namespace{
@@ -376,6 +366,8 @@ void Timepix3Producer::DoConfigure() {
   // Maximum pixel vector size and how many pixels to clean from it (to handle backlog)
   m_maxPixVec = config->Get( "MaxPixelVecSize", 10000 );
   m_pixToDel  = config->Get( "NpixelsToDelete", 5000 );
+  // raw SPIDR packets are written here for an offline replay
+  m_dumpfileName = config->Get( "SPIDR_DumpFile", "" );
 
   // Also display something for us
   cout << endl;
@@ -531,15 +523,19 @@ void Timepix3Producer::RunLoop() {
     EUDAQ_ERROR("setTluEnable: " + spidrctrl->errorString());
   }
 
-  // Vectors to contain pixel and trigger structures
-  vector< PIXEL > pixel_vec;
-  pixel_vec.reserve( 10000000 );
-  vector< TRIGGER > trigger_vec;
-  trigger_vec.reserve( 10000000 );
-  int last_trg_timestamp=0;
-  uint64_t unfolded_timestamp=0;
-  int last_fpga_ts=0x00000; //SAMIR: was 0x10000
-  const uint64_t TIMER_EPOCH = 0x40000000;
+  // Matches the pixels to the triggers
+  Timepix3EventBuilder builder( m_maxPixVec, m_pixToDel );
+  Timepix3EventBuilder::TRIGGER trigger;
+  std::vector< Timepix3EventBuilder::PIXEL > pixels;
+  std::ofstream dumpfile;
+  if( !m_dumpfileName.empty() ) {
+    dumpfile.open( m_dumpfileName, std::ios::binary );
+    if( !dumpfile )
+      EUDAQ_WARN("Cannot open SPIDR dump file " + m_dumpfileName);
+  }
+  std::vector< uint64_t > dump;
+  uint64_t pix_n = 0;
+  uint64_t max_build_time = 0;
   int cnt = 0;
 
   while(1) {
@@ -557,6 +553,11 @@ void Timepix3Producer::RunLoop() {
     // Log some info
     if(m_ev >= m_ev_next_update) {
       EUDAQ_USER("Timepix3 temperature: " + std::to_string(getTpx3Temperature()) + "°C");
+      EUDAQ_INFO("Timepix3 events: " + std::to_string(m_ev) + ", pixels: " + std::to_string(pix_n) +
+		 ", pixels dropped: " + std::to_string(builder.GetDroppedN()) +
+		 ", pixels left: " + std::to_string(builder.GetPixelN()) +
+		 ", max build time: " + std::to_string(max_build_time) + "us");
+      max_build_time = 0;
       m_ev_next_update=m_ev+10000;
     }
 
@@ -565,8 +566,6 @@ void Timepix3Producer::RunLoop() {
       ++cnt;
       size = spidrdaq->sampleSize();
 
-      const int HALF_EPOCH=0x8000;
-
       // look inside sample buffer...
       while( 1 ) {
 
@@ -575,174 +574,50 @@ void Timepix3Producer::RunLoop() {
 	// ...until the sample buffer is empty
 	if( !data ) break;
 
-	uint64_t header = data & 0xF000000000000000;
-
-	// Data-driven or sequential readout pixel data header?
-	if( header == 0xB000000000000000 || header == 0xA000000000000000 ) {
-	  struct PIXEL pixel;
-
-	  unsigned char x, y, ftoa;
-	  uint64_t pixdata, tot, toa;
-	  uint64_t fpga_ts;
-	  long long pix_ts;
-	  uint64_t dcol, spix, pix;
-	  // doublecolumn * 2
-	  dcol  = (( data & 0x0FE0000000000000 ) >> 52 ); //(16+28+9-1)
-	  // superpixel * 4
-	  spix  = (( data & 0x001F800000000000 ) >> 45 ); //(16+28+3-2)
-	  // pixel
-	  pix   = (( data & 0x0000700000000000) >> 44 ); //(16+28)
-	  pixel.x    = (unsigned char) ( dcol + pix/4 );
-	  pixel.y    = (unsigned char) ( spix + ( pix & 0x3 ) );
-	  // pixel data
-	  pixdata = (int) (( data & 0x00000FFFFFFF0000 ) >> 16 );
-	  pixel.tot  =  ( pixdata >> 4 ) & 0x3FF;
-
-	  // timestamp calculation
-	  ftoa = pixdata & 0xF;
-	  toa  = ( pixdata >> 14 ) & 0x3FFF;
-	  fpga_ts = (int) (data & 0x000000000000FFFF);
-	  pix_ts = ( fpga_ts << 14 ) | toa;
-
-	  if ( (int)fpga_ts < ((int)last_fpga_ts - HALF_EPOCH) ) {
-	    unfolded_timestamp+=TIMER_EPOCH;
-#ifdef TPX3_VERBOSE
-	    cout << "-- unfolding (pix) --\n";
-#endif
-
-	    last_fpga_ts = fpga_ts;
-	  } else if ( (int)fpga_ts >= ((int)last_fpga_ts + HALF_EPOCH) ) {
-	    pix_ts -= TIMER_EPOCH;
-	  } else {
-	    last_fpga_ts = fpga_ts;
-	  }
-	  pix_ts += unfolded_timestamp;
-	  pix_ts <<= 4;
-	  pix_ts -= ftoa;
-	  pixel.ts = pix_ts;
-
-	  // store PIXEL struct in vector
-	  pixel_vec.push_back( pixel );
-	  if (pixel_vec.size()>m_maxPixVec) {
-	    pixel_vec.erase (pixel_vec.begin(),pixel_vec.begin()+m_pixToDel);
-#ifdef TPX3_VERBOSE
-	    std::cout << "Removing pixel data, too much back log!"<< std::endl;
-#endif
-	  }
-	  // print it
-#ifdef TPX3_VERBOSE
-	  printf("[PIXDATA] (%3d,%3d) TOT:%5d TOA:%5d FPGA_TS:%6d       TS:%15llu\n", pixel.x , pixel.y , pixel.tot, toa , fpga_ts, pixel.ts );
-#endif
-	} else if( header == 0x5000000000000000 ) { // Or TLU packet header?
-	  struct TRIGGER trigger;
-	  uint64_t fpga_ts;
-	  unsigned short int_trg_nr, tlu_trg_nr;
-	  long long trg_timestamp;
-	  //internal trigger number
-	  trigger.int_nr = (data >> 45) & 0x7FFF;
-	  //TLU trigger number
-	  trigger.tlu_nr = (data >> 30) & 0x7FFF;
-
-	  //timestamp
-	  trg_timestamp = data & 0x3FFFFFFF;
-	  fpga_ts = (int) ((trg_timestamp>>14) & 0x000000000000FFFF);
-	  if ( (int)fpga_ts < ((int)last_fpga_ts - HALF_EPOCH) )
-	    {
-	      unfolded_timestamp += TIMER_EPOCH;
-#ifdef TPX3_VERBOSE
-	      cout << "-- unfolding (trg) --\n";
-#endif
-	      last_fpga_ts = fpga_ts;
-	    } else if ( fpga_ts >= last_fpga_ts +HALF_EPOCH  )
-	    trg_timestamp-=TIMER_EPOCH;
-	  else
-	    last_fpga_ts = fpga_ts;
-
-	  trg_timestamp += unfolded_timestamp;
-	  trg_timestamp <<= 4;
-	  trigger.ts = trg_timestamp;
+	if( dumpfile.is_open() )
+	  dump.push_back( data );
 
+	// only a trigger can complete an event
+	uint64_t header = data & 0xF000000000000000;
+	builder.AddPacket( data );
+	if( header != 0x5000000000000000 )
+	  continue;
+
+	while( builder.NextEvent( trigger, pixels ) ) {
+	  uint64_t start_time=GetTimeus();
+	  // Current event
+	  auto evup = eudaq::Event::MakeUnique("Timepix3RawDataEvent");
+	  evup->SetTriggerN(m_ev);
+
+	  std::vector<unsigned char> bufferTrg;
+	  std::vector<unsigned char> bufferPix;
+	  Timepix3EventBuilder::PackTrigger( trigger, bufferTrg );
+	  Timepix3EventBuilder::PackPixels( pixels, bufferPix );
 #ifdef TPX3_VERBOSE
-	  printf("[TRGDATA] tlu_id:%5d int_id:%5d                          TS:%15llu\n", trigger.tlu_nr , trigger.int_nr, trigger.ts);
-#endif
-	  // store TRIGGER struct in vector
-	  trigger_vec.push_back( trigger );
-
-	  // Loop over pixel and trigger vectors
-	  while( trigger_vec.size() > 1 ) {
-	    uint64_t start_time=GetTimeus();
-	    // Current event
-	    auto evup = eudaq::Event::MakeUnique("Timepix3RawDataEvent");
-	    evup->SetTriggerN(m_ev);
-
-	    std::vector<unsigned char> bufferTrg;
-	    std::vector<unsigned char> bufferPix;
-
-	    uint64_t curr_trg_ts = trigger_vec[0].ts;
-	    uint64_t next_trg_ts = trigger_vec[1].ts;
-	    uint64_t max_pixel_ts = ( next_trg_ts + curr_trg_ts ) / 2;
-
-	    uint64_t curr_tlu_nr = trigger_vec[0].tlu_nr;
-	    uint64_t curr_int_nr = trigger_vec[0].int_nr;
-
-	    // pack TLU info in its buffer
-	    pack( bufferTrg, curr_trg_ts);
-	    pack( bufferTrg, curr_tlu_nr);
-	    pack( bufferTrg, curr_int_nr);
-
-	    // and add it to the event
-	    evup->AddBlock( 0, bufferTrg );
-#ifdef TPX3_VERBOSE
-	    uint64_t fpts=0;
-	    if (pixel_vec.size()>0) fpts=pixel_vec[0].ts;
-	    printf("\n=> processing tr_id %5d  ts: %15lu max_ts: %15lu next_trg_ts: %15lu  (pix vec size: %d, first pix ts: %lu)\n", trigger_vec[0].tlu_nr,curr_trg_ts, max_pixel_ts, next_trg_ts , pixel_vec.size(),fpts);
-
-#endif
-
-	    // Loop over pixels
-	    for( int j = 0; j < pixel_vec.size(); ++j ) {
-	      uint64_t curr_pix_ts = pixel_vec[j].ts;
-	      if( curr_pix_ts < max_pixel_ts ) {
-
-#ifdef TPX3_VERBOSE
-		printf("                        +  ts: %15lu diff: %15ld  (pix %3d,%3d)\n", curr_pix_ts, diff, pixel_vec[j].x, pixel_vec[j].y );
-#endif
-		// Pack pixel data into event buffer
-		pack( bufferPix, pixel_vec[j].x );
-		pack( bufferPix, pixel_vec[j].y );
-		pack( bufferPix, pixel_vec[j].tot );
-		pack( bufferPix, pixel_vec[j].ts );
-
-		pixel_vec.erase( pixel_vec.begin() + j );
-		j--; // after removing one pixel data packet, need to go back one step in the vector to avoid skipping pixels
-	      }
-	      else if( curr_pix_ts > next_trg_ts ) {
-#ifdef TPX3_VERBOSE
-		printf("                        -> break! (%lu > %lu , diff:%ld)\n",curr_pix_ts,next_trg_ts,curr_pix_ts-next_trg_ts  );
+	  printf("\n=> processing tr_id %5d  ts: %15lu  (%lu pixels, pix vec size: %lu)\n", trigger.tlu_nr, trigger.ts, pixels.size(), builder.GetPixelN());
 #endif
-		break;
-	      }
-	    }
-
-	    // Remove trigger from vector
-	    trigger_vec.erase( trigger_vec.begin() );
-	    // Add buffer to block
-	    evup->AddBlock( 1, bufferPix );
-	    // Send the event to the Data Collector
-	    SendEvent(std::move(evup));
-
-	    uint64_t stop_time=GetTimeus();
-	    uint64_t dt=stop_time-start_time;
-	    printf("[ev:%6u|tlu:%5lu] Pixels:%5lu Buildtime:%6luus Pixels left:%6lu\n",m_ev,curr_tlu_nr,bufferPix.size(),dt,pixel_vec.size());
-	    fflush( stdout );
-	    // Now increment the event number
-	    m_ev++;
-	  }
+	  // and add them to the event
+	  evup->AddBlock( 0, bufferTrg );
+	  evup->AddBlock( 1, bufferPix );
+	  // Send the event to the Data Collector
+	  SendEvent(std::move(evup));
+
+	  uint64_t dt=GetTimeus()-start_time;
+	  if( dt > max_build_time )
+	    max_build_time = dt;
+	  pix_n += pixels.size();
+	  // Now increment the event number
+	  m_ev++;
 	}
       } // End loop over sample buffer
 
-      printf("Pixels left: %5lu Triggers:%5lu\n",pixel_vec.size(), trigger_vec.size());
-      fflush( stdout );
+      if( !dump.empty() ) {
+	dumpfile.write( reinterpret_cast<const char*>(dump.data()), dump.size()*sizeof(uint64_t) );
+	dump.clear();
+      }
+#ifdef TPX3_VERBOSE
+      printf("Pixels left: %5lu Triggers:%5lu\n", builder.GetPixelN(), builder.GetTriggerN());
+#endif
     }
   }
 